@@ -0,0 +1,46 @@
+#ifndef CONTENT_HASH_H_
+#define CONTENT_HASH_H_
+
+#include <QtGlobal>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "parallel.h"
+
+namespace s21 {
+
+const size_t kHashBlock = 4 << 20;
+const quint64 kHashPrime = 0x100000001B3ull;
+
+// Fast non-cryptographic hash: one multiply and shift per 8 bytes.
+inline quint64 HashBytes(const char *data, size_t size, quint64 seed) {
+  quint64 hash = seed ^ (size * 0x9E3779B97F4A7C15ull);
+  size_t i = 0;
+  for (; i + sizeof(quint64) <= size; i += sizeof(quint64)) {
+    quint64 word;
+    std::memcpy(&word, data + i, sizeof(word));
+    hash = (hash ^ word) * kHashPrime;
+    hash ^= hash >> 29;
+  }
+  for (; i < size; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(data[i])) * kHashPrime;
+  }
+  return hash;
+}
+
+// Hashes blocks of kHashBlock bytes in parallel, then their hashes.
+inline quint64 HashContent(const char *data, size_t size) {
+  const size_t blocks = (size + kHashBlock - 1) / kHashBlock;
+  std::vector<quint64> hashes(blocks);
+  ParallelFor(blocks, [&](size_t i) {
+    const size_t begin = i * kHashBlock;
+    hashes[i] = HashBytes(data + begin, std::min(kHashBlock, size - begin), i);
+  });
+  return HashBytes(reinterpret_cast<const char *>(hashes.data()),
+                   blocks * sizeof(quint64), size);
+}
+
+}  // namespace s21
+
+#endif  // CONTENT_HASH_H_
@@ -0,0 +1,323 @@
+#include "mesh_cache.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <cstring>
+
+#include "content_hash.h"
+#include "global_settings.h"
+
+namespace s21 {
+
+namespace {
+
+const char kMagic[4] = {'V', '3', 'D', 'C'};
+const quint32 kVersion = 1;
+const qint64 kDefaultLimit = 1024;
+
+class Writer {
+ public:
+  explicit Writer(QIODevice *device) : m_device_{device} {}
+
+  void Append(const void *data, size_t size) {
+    const qint64 written =
+        m_device_->write(static_cast<const char *>(data), size);
+    m_failed_ = m_failed_ || written != qint64(size);
+    m_size_ += size;
+  }
+  void AppendU32(quint32 value) { Append(&value, sizeof(value)); }
+  void AppendFloat(float value) { Append(&value, sizeof(value)); }
+  void AppendVector(const QVector3D &value) {
+    for (int i = 0; i < 3; ++i) AppendFloat(value[i]);
+  }
+  void AppendString(const QString &value) {
+    const QByteArray bytes = value.toUtf8();
+    AppendU32(bytes.size());
+    Append(bytes.constData(), bytes.size());
+  }
+  void Align(size_t alignment) {
+    const char zero[16] = {};
+    Append(zero, (alignment - m_size_ % alignment) % alignment);
+  }
+  qint64 GetSize() const { return m_size_; }
+  bool IsFailed() const { return m_failed_; }
+
+ private:
+  QIODevice *m_device_;
+  qint64 m_size_ = 0;
+  bool m_failed_ = false;
+};
+
+class Reader {
+ public:
+  Reader(const char *data, qint64 size)
+      : m_begin_{data}, m_p_{data}, m_end_{data + size} {}
+
+  const char *Take(size_t size) {
+    if (size_t(m_end_ - m_p_) < size) return nullptr;
+    const char *p = m_p_;
+    m_p_ += size;
+    return p;
+  }
+  bool Read(void *data, size_t size) {
+    const char *p = Take(size);
+    if (p) std::memcpy(data, p, size);
+    return p;
+  }
+  bool ReadU32(quint32 &value) { return Read(&value, sizeof(value)); }
+  bool ReadFloat(float &value) { return Read(&value, sizeof(value)); }
+  bool ReadVector(QVector3D &value) {
+    for (int i = 0; i < 3; ++i) {
+      if (!ReadFloat(value[i])) return false;
+    }
+    return true;
+  }
+  bool ReadString(QString &value) {
+    quint32 size = 0;
+    const char *p = ReadU32(size) ? Take(size) : nullptr;
+    if (p) value = QString::fromUtf8(p, size);
+    return p;
+  }
+  bool Align(size_t alignment) {
+    const size_t offset = m_p_ - m_begin_;
+    return Take((alignment - offset % alignment) % alignment);
+  }
+
+ private:
+  const char *m_begin_;
+  const char *m_p_;
+  const char *m_end_;
+};
+
+}  // namespace
+
+MeshCache::MeshCache(QString path, unsigned int flags)
+    : m_path_{QFileInfo(path).absoluteFilePath()}, m_flags_{flags} {
+  const QByteArray key = m_path_.toUtf8();
+  const quint64 hash = HashBytes(key.constData(), key.size(), flags);
+  m_entry_ = GetDirectory().filePath(QString::number(hash, 16) + ".v3dc");
+}
+
+bool MeshCache::Load(QVector<MeshData> &meshes) {
+  QFile file(m_entry_);
+  if (!IsEnabled() || !file.exists() || !ReadSource()) {
+    return false;
+  }
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+
+  QByteArray buffer;
+  const qint64 size = file.size();
+  const char *data = reinterpret_cast<const char *>(file.map(0, size));
+  if (!data) {
+    buffer = file.readAll();
+    data = buffer.constData();
+  }
+
+  QVector<MeshData> result;
+  if (!Parse(data, size, result)) {
+    file.close();
+    file.remove();
+    return false;
+  }
+  file.close();
+
+  if (file.open(QIODevice::Append)) {
+    file.setFileTime(QDateTime::currentDateTime(),
+                     QFileDevice::FileModificationTime);
+  }
+  meshes = std::move(result);
+  return true;
+}
+
+void MeshCache::Store(const QVector<MeshData> &meshes) {
+  if (!IsEnabled() || !ReadSource()) {
+    return;
+  }
+
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.flags = m_flags_;
+  header.vertex_size = sizeof(Vertex);
+  header.mesh_count = meshes.size();
+  header.source_size = m_source_size_;
+  header.source_mtime = m_source_mtime_;
+  header.source_hash = m_source_hash_;
+
+  const qint64 limit = GetLimit() * 1024 * 1024;
+  GetDirectory().mkpath(".");
+  QSaveFile file(m_entry_);
+  if (!file.open(QIODevice::WriteOnly)) {
+    return;
+  }
+
+  Writer writer(&file);
+  writer.Append(&header, sizeof(header));
+  for (auto &it : meshes) {
+    writer.AppendString(it.name);
+
+    const Material &material = it.material;
+    writer.AppendVector(material.Ka);
+    writer.AppendVector(material.Kd);
+    writer.AppendVector(material.Ks);
+    writer.AppendVector(material.Ke);
+    writer.AppendFloat(material.Ns);
+    writer.AppendFloat(material.Ni);
+    writer.AppendFloat(material.refraction);
+    writer.AppendFloat(material.reflection);
+    writer.AppendFloat(material.roughness);
+    writer.AppendFloat(material.d);
+    writer.AppendU32(material.illum);
+
+    writer.AppendU32(it.textures.size());
+    for (auto &texture : it.textures) {
+      writer.AppendString(texture.type);
+      writer.AppendString(texture.path);
+    }
+
+    writer.AppendVector(it.min_value);
+    writer.AppendVector(it.max_value);
+    writer.AppendU32(it.vertices.size());
+    writer.AppendU32(it.indices.size());
+
+    writer.Align(16);
+    writer.Append(it.vertices.constData(), it.vertices.size() * sizeof(Vertex));
+    writer.Append(it.indices.constData(),
+                  it.indices.size() * sizeof(unsigned int));
+    if (writer.IsFailed() || writer.GetSize() > limit) {
+      file.cancelWriting();
+      return;
+    }
+  }
+  file.commit();
+  Evict(limit);
+}
+
+bool MeshCache::IsEnabled() {
+  return !GlobalSetting::haveSettings("meshCacheEnabled") ||
+         GlobalSetting::getSettings("meshCacheEnabled").toBool();
+}
+
+void MeshCache::SetEnabled(bool enabled) {
+  GlobalSetting::setSettings("meshCacheEnabled", enabled);
+}
+
+qint64 MeshCache::GetLimit() {
+  if (!GlobalSetting::haveSettings("meshCacheLimit")) {
+    return kDefaultLimit;
+  }
+  return GlobalSetting::getSettings("meshCacheLimit").toLongLong();
+}
+
+void MeshCache::SetLimit(qint64 megabytes) {
+  GlobalSetting::setSettings("meshCacheLimit", megabytes);
+  Evict(megabytes * 1024 * 1024);
+}
+
+QDir MeshCache::GetDirectory() {
+  return QDir(
+      QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+      "/meshes");
+}
+
+void MeshCache::Clear() { GetDirectory().removeRecursively(); }
+
+bool MeshCache::ReadSource() {
+  if (m_source_ready_) {
+    return true;
+  }
+
+  QFile file(m_path_);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  m_source_size_ = file.size();
+  m_source_mtime_ = QFileInfo(m_path_).lastModified().toMSecsSinceEpoch();
+
+  const char *data =
+      reinterpret_cast<const char *>(file.map(0, m_source_size_));
+  if (data) {
+    m_source_hash_ = HashContent(data, m_source_size_);
+  } else {
+    const QByteArray buffer = file.readAll();
+    m_source_hash_ = HashContent(buffer.constData(), buffer.size());
+  }
+  m_source_ready_ = true;
+  return true;
+}
+
+bool MeshCache::Parse(const char *data, qint64 size,
+                      QVector<MeshData> &meshes) const {
+  Reader reader(data, size);
+
+  Header header;
+  if (!reader.Read(&header, sizeof(header)) ||
+      std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion || header.flags != m_flags_ ||
+      header.vertex_size != sizeof(Vertex) ||
+      header.source_size != m_source_size_ ||
+      header.source_mtime != m_source_mtime_ ||
+      header.source_hash != m_source_hash_) {
+    return false;
+  }
+
+  meshes.resize(header.mesh_count);
+  for (auto &it : meshes) {
+    Material &material = it.material;
+    quint32 texture_count = 0, vertex_count = 0, index_count = 0;
+    bool ok = reader.ReadString(it.name) && reader.ReadVector(material.Ka) &&
+              reader.ReadVector(material.Kd) &&
+              reader.ReadVector(material.Ks) &&
+              reader.ReadVector(material.Ke) && reader.ReadFloat(material.Ns) &&
+              reader.ReadFloat(material.Ni) &&
+              reader.ReadFloat(material.refraction) &&
+              reader.ReadFloat(material.reflection) &&
+              reader.ReadFloat(material.roughness) &&
+              reader.ReadFloat(material.d) && reader.ReadU32(material.illum) &&
+              reader.ReadU32(texture_count);
+    for (quint32 i = 0; ok && i < texture_count; ++i) {
+      TextureRef texture;
+      ok = reader.ReadString(texture.type) && reader.ReadString(texture.path);
+      it.textures.push_back(texture);
+    }
+    ok = ok && reader.ReadVector(it.min_value) &&
+         reader.ReadVector(it.max_value) && reader.ReadU32(vertex_count) &&
+         reader.ReadU32(index_count) && reader.Align(16);
+    if (!ok) {
+      return false;
+    }
+
+    const char *vertices = reader.Take(size_t(vertex_count) * sizeof(Vertex));
+    const char *indices =
+        reader.Take(size_t(index_count) * sizeof(unsigned int));
+    if (!vertices || !indices) {
+      return false;
+    }
+    it.vertices.resize(vertex_count);
+    std::memcpy(it.vertices.data(), vertices, vertex_count * sizeof(Vertex));
+    it.indices.resize(index_count);
+    std::memcpy(it.indices.data(), indices,
+                index_count * sizeof(unsigned int));
+  }
+  return true;
+}
+
+void MeshCache::Evict(qint64 limit) {
+  qint64 total = 0;
+  const QFileInfoList entries =
+      GetDirectory().entryInfoList({"*.v3dc"}, QDir::Files, QDir::Time);
+  for (auto &it : entries) {
+    total += it.size();
+    if (total > limit) {
+      QFile::remove(it.absoluteFilePath());
+    }
+  }
+}
+
+}  // namespace s21
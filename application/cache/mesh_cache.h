@@ -0,0 +1,56 @@
+#ifndef MESH_CACHE_H_
+#define MESH_CACHE_H_
+
+#include <QByteArray>
+#include <QDir>
+#include <QString>
+#include <QVector>
+
+#include "mesh_data.h"
+
+namespace s21 {
+
+class MeshCache {
+ public:
+  MeshCache(QString path, unsigned int flags);
+
+  bool Load(QVector<MeshData> &meshes);
+  void Store(const QVector<MeshData> &meshes);
+
+  static bool IsEnabled();
+  static void SetEnabled(bool enabled);
+  static qint64 GetLimit();
+  static void SetLimit(qint64 megabytes);
+  static QDir GetDirectory();
+  static void Clear();
+
+ private:
+  struct Header {
+    char magic[4];
+    quint32 version;
+    quint32 flags;
+    quint32 vertex_size;
+    quint32 mesh_count;
+    quint32 reserved;
+    qint64 source_size;
+    qint64 source_mtime;
+    quint64 source_hash;
+  };
+
+  bool ReadSource();
+  bool Parse(const char *data, qint64 size, QVector<MeshData> &meshes) const;
+  static void Evict(qint64 limit);
+
+  QString m_path_;
+  QString m_entry_;
+  unsigned int m_flags_;
+
+  bool m_source_ready_ = false;
+  qint64 m_source_size_ = 0;
+  qint64 m_source_mtime_ = 0;
+  quint64 m_source_hash_ = 0;
+};
+
+}  // namespace s21
+
+#endif  // MESH_CACHE_H_
@@ -21,6 +21,8 @@ QVector3D Camera::GetViewDiraction() const { return m_front_; }
 
 float Camera::GetZoom() const { return m_zoom_; }
 
+quint64 Camera::GetRevision() const { return m_revision_; }
+
 void Camera::ChangeFocus(QVector3D dir) {
   QVector3D temp(dir - m_position_);
   temp.normalize();
@@ -56,6 +58,7 @@ void Camera::ProcessKeyboard(int direction, float delta_time) {
   if (direction == Qt::Key_D) m_position_ += m_right_ * velocity;
   if (direction == Qt::Key_R) m_position_ += m_up_ * velocity;
   if (direction == Qt::Key_F) m_position_ -= m_up_ * velocity;
+  ++m_revision_;
 }
 
 void Camera::ProcessMouseMovement(float xoffset, float yoffset,
@@ -77,6 +80,7 @@ void Camera::ProcessMouseScroll(float yoffset) {
   m_zoom_ -= (float)yoffset;
   if (m_zoom_ < 1.0f) m_zoom_ = 1.0f;
   if (m_zoom_ > 45.0f) m_zoom_ = 45.0f;
+  ++m_revision_;
 }
 
 void Camera::UpdateCameraVectors() {
@@ -89,6 +93,7 @@ void Camera::UpdateCameraVectors() {
 
   m_right_ = QVector3D::normal(m_front_, m_world_up_);
   m_up_ = QVector3D::normal(m_right_, m_front_);
+  ++m_revision_;
 }
 
 }  // namespace s21
@@ -24,6 +24,8 @@ class Camera {
 
   float m_zoom_ = 45.0f;
 
+  quint64 m_revision_ = 0;
+
  public:
   Camera(QVector3D position = QVector3D(0.0f, 0.0f, 0.0f),
          QVector3D up = QVector3D(0.0f, 1.0f, 0.0f));
@@ -32,6 +34,8 @@ class Camera {
   QVector3D GetPosition() const;
   QVector3D GetViewDiraction() const;
   float GetZoom() const;
+  // Grows on every change of position, direction or zoom.
+  quint64 GetRevision() const;
 
   void ChangeFocus(QVector3D dir);
 
@@ -1,5 +1,14 @@
 #include "mainwindow.h"
 
+#include "buffer_arena.h"
+#include "geometry_store.h"
+#include "index_format.h"
+#include "mesh_batcher.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "texture_cache.h"
+#include "vertex_format.h"
+
 namespace s21 {
 
 MainWindow::MainWindow(QWidget *parent)
@@ -10,6 +19,8 @@ MainWindow::MainWindow(QWidget *parent)
   SetItemList();
   SetLightList();
   SetLightWindow();
+  SetLoadProgress();
+  SetFrameStats();
 }
 
 MainWindow::~MainWindow() { delete ui; }
@@ -53,6 +64,16 @@ void MainWindow::ConnectModelRegister() {
 
   connect(ui->wgt_gl, SIGNAL(getSceneData()), this, SLOT(LoadSettings()));
   connect(ui->wgt_gl, SIGNAL(Error(QString)), this, SLOT(on_error(QString)));
+
+  connect(ui->wgt_gl, SIGNAL(ModelReady(QString)), this,
+          SLOT(AddModelLable(QString)));
+  connect(ui->wgt_gl, SIGNAL(LoadProgress(qint64, qint64, int, int, qint64)),
+          this, SLOT(LoadProgress(qint64, qint64, int, int, qint64)));
+  connect(ui->wgt_gl, SIGNAL(LoadFinished()), this, SLOT(LoadFinished()));
+  connect(ui->wgt_gl, SIGNAL(FrameStats(qint64, qint64, qint64, qint64)), this,
+          SLOT(FrameStats(qint64, qint64, qint64, qint64)));
+  connect(ui->wgt_gl, SIGNAL(StateStats(qint64, qint64, qint64)), this,
+          SLOT(StateStats(qint64, qint64, qint64)));
 }
 
 void MainWindow::ConnectLightRegister() {
@@ -64,8 +85,9 @@ void MainWindow::ConnectLightRegister() {
   connect(this, SIGNAL(ChangeCurrentLight(QString, int)), illumination,
           SLOT(ChangeCurrent(QString, int)));
 
-  connect(illumination, SIGNAL(CurrentLightInfo(QMap<QString, QVariant>)), this,
-          SLOT(SetLightInfo(QMap<QString, QVariant>)));
+  connect(illumination,
+          SIGNAL(CurrentLightInfo(QVector3D, QVector3D, double, double)), this,
+          SLOT(SetLightInfo(QVector3D, QVector3D, double, double)));
 
   connect(ui->directionLight_x_spb, SIGNAL(valueChanged(double)), illumination,
           SLOT(ChangeDirectionX(double)));
@@ -131,7 +153,9 @@ void MainWindow::on_act_open_file_triggered() {
   if (!last_path.isEmpty()) {
     ui->wgt_gl->LoadModel(last_path);
     settings_.setSettings("lastDialogPath", last_path);
-    AddModelLable(last_path);
+    load_progress_->setValue(0);
+    load_progress_->show();
+    load_cancel_->show();
   }
 }
 
@@ -413,7 +437,7 @@ void MainWindow::SetCurentModel(Model *curent_obj) {
 
 void MainWindow::SetCurentMesh() {
   if (obj_) {
-    Mesh *current_mesh = obj_->GetCurrentMesh();
+    MeshPart *current_mesh = obj_->GetCurrentMesh();
     if (current_mesh) {
       SetMeshInfo();
       auto &cur_material = current_mesh->GetMaterial();
@@ -433,6 +457,8 @@ void MainWindow::SetMeshInfo() {
                  "        ");
   message.append("Vertex count: " + QString::number(info.vertices_count) +
                  "        ");
+  message.append("LOD levels: " + QString::number(info.lod_count) +
+                 "        ");
   ui->statusbar->showMessage(message);
 }
 
@@ -444,6 +470,47 @@ void MainWindow::SetModelInfo() {
                    "        ");
     message.append("Vertex count: " + QString::number(info.GetVerticeCount()) +
                    "        ");
+    message.append("Vertex memory: " +
+                   QString::number(info.GetVertexBytes() / 1024) +
+                   " KB        ");
+    const qint64 index_bytes = info.GetIndexBytes();
+    const qint64 saved = qint64(info.GetFaceCount()) * 3 * 4 - index_bytes;
+    message.append("Index memory: " + QString::number(index_bytes / 1024) +
+                   " KB (saved " + QString::number(saved / 1024) +
+                   " KB)        ");
+    if (info.GetLodBytes()) {
+      message.append("LOD memory: " +
+                     QString::number(info.GetLodBytes() / 1024) +
+                     " KB        ");
+    }
+    message.append("Unique polygons: " +
+                   QString::number(info.GetUniqueFaces()) + " / " +
+                   QString::number(info.GetFaceCount()) + "        ");
+    if (info.GetSharedBytes()) {
+      message.append("Shared geometry: saved " +
+                     QString::number(info.GetSharedBytes() / 1024) +
+                     " KB        ");
+    }
+    const VertexCacheStats &stats = info.GetCacheStats();
+    const VertexCacheStats &before = info.GetCacheStatsBefore();
+    message.append("ACMR: " + QString::number(stats.GetAcmr(), 'f', 2));
+    if (before.triangles) {
+      message.append(" (was " + QString::number(before.GetAcmr(), 'f', 2) +
+                     ")");
+    }
+    message.append("  ATVR: " + QString::number(stats.GetAtvr(), 'f', 2));
+    if (before.triangles) {
+      message.append(" (was " + QString::number(before.GetAtvr(), 'f', 2) +
+                     ")");
+    }
+    message.append("        ");
+    message.append("Peak memory: " +
+                   QString::number(info.GetPeakMemory() / (1024 * 1024)) +
+                   " MB        ");
+    message.append("Textures: " + QString::number(TextureCache::GetCount()) +
+                   " (" +
+                   QString::number(TextureCache::GetBytes() / (1024 * 1024)) +
+                   " MB)        ");
     ui->statusbar->showMessage(message);
   }
 }
@@ -535,6 +602,15 @@ void MainWindow::LoadSettings() {
   ui->menu_skybox_type->actions()
       .at(settings_.getSettings("skyboxType").toInt())
       ->trigger();
+  const bool continuous = settings_.getSettings("continuousRender").toBool();
+  ui->act_continuous_render->setChecked(continuous);
+  ui->wgt_gl->SetContinuous(continuous);
+  ui->act_cache_enabled->setChecked(MeshCache::IsEnabled());
+  ui->act_compact_vertices->setChecked(VertexFormat::IsCompact());
+  ui->act_split_meshes->setChecked(IndexFormat::IsSplit());
+  ui->act_batch_meshes->setChecked(MeshBatcher::IsEnabled());
+  ui->act_optimize_meshes->setChecked(MeshOptimizer::IsEnabled());
+  ui->act_build_lods->setChecked(MeshSimplifier::IsEnabled());
 }
 
 void MainWindow::on_act_background_color_triggered() {
@@ -644,7 +720,7 @@ void MainWindow::on_treeLights_clicked(const QModelIndex &index) {
     if (parent.model() == nullptr) {
       if (index.row() == 0) {
         ShowLightSettings(index.row());
-        emit ChangeCurrentLight(type, index.row());
+        emit ChangeCurrentLight(type, Illumination::kSceneLight);
       }
     } else {
       ShowLightSettings(parent.row());
@@ -653,10 +729,11 @@ void MainWindow::on_treeLights_clicked(const QModelIndex &index) {
       } else if (parent.row() == 2) {
         type = "spotLight";
       }
+      const int handle = index.siblingAtColumn(0).data(Qt::UserRole).toInt();
       if (index.column() == 2) {
         QStandardItemModel *model = (QStandardItemModel *)parent.model();
         model->removeRow(index.row(), parent);
-        emit RemoveLight(type, index.row());
+        emit RemoveLight(type, handle);
         QModelIndex new_index =
             ui->treeLights->selectionModel()->currentIndex();
         new_index = new_index.siblingAtColumn(0);
@@ -665,7 +742,7 @@ void MainWindow::on_treeLights_clicked(const QModelIndex &index) {
         }
         emit ui->treeLights->clicked(new_index);
       } else {
-        emit ChangeCurrentLight(type, index.row());
+        emit ChangeCurrentLight(type, handle);
       }
     }
   }
@@ -726,35 +803,34 @@ void MainWindow::AddLightOnTree(int index) {
   QStandardItem *Parent_item = model->item(index, 0);
   QString lightName;
   int count = Parent_item->rowCount();
-  if (count < 20) {
-    switch (index) {
-      case 0:
-        lightName = "dirLight";
-        break;
-      case 1:
-        lightName = "pointLight";
-        break;
-      case 2:
-        lightName = "spotLight";
-        break;
-      default:
-        break;
-    }
-    ui->wgt_gl->addLight(lightName);
-    lightName += "[" + QString::number(count) + "]";
-    QStandardItem *item = new QStandardItem(lightName);
-    QList<QStandardItem *> list_item;
-    list_item.append(item);
-    item = new QStandardItem();
-    item->setEditable(false);
-    item->setCheckable(true);
-    item->setCheckState(Qt::Checked);
-    list_item.append(item);
-    item = new QStandardItem("Remove");
-    item->setEditable(false);
-    list_item.append(item);
-    Parent_item->appendRow(list_item);
+  switch (index) {
+    case 0:
+      lightName = "dirLight";
+      break;
+    case 1:
+      lightName = "pointLight";
+      break;
+    case 2:
+      lightName = "spotLight";
+      break;
+    default:
+      break;
   }
+  const int handle = ui->wgt_gl->addLight(lightName);
+  lightName += "[" + QString::number(count) + "]";
+  QStandardItem *item = new QStandardItem(lightName);
+  item->setData(handle, Qt::UserRole);
+  QList<QStandardItem *> list_item;
+  list_item.append(item);
+  item = new QStandardItem();
+  item->setEditable(false);
+  item->setCheckable(true);
+  item->setCheckState(Qt::Checked);
+  list_item.append(item);
+  item = new QStandardItem("Remove");
+  item->setEditable(false);
+  list_item.append(item);
+  Parent_item->appendRow(list_item);
 }
 
 void MainWindow::on_add_point_light_btn_clicked() { AddLightOnTree(1); }
@@ -765,9 +841,9 @@ void MainWindow::item_changed(QStandardItem *item) {
   if (item->index().parent().model() == nullptr) {
     if (!item->index().row()) {
       if (item->checkState()) {
-        ui->wgt_gl->setEnableLight("dirLight", item->index().row());
+        ui->wgt_gl->setEnableLight("dirLight", Illumination::kSceneLight);
       } else {
-        ui->wgt_gl->setDisableLight("dirLight", item->index().row());
+        ui->wgt_gl->setDisableLight("dirLight", Illumination::kSceneLight);
       }
     } else {
       QStandardItem *item_child;
@@ -790,35 +866,27 @@ void MainWindow::item_changed(QStandardItem *item) {
         default:
           break;
       }
+      const int handle =
+          item->parent()->child(item->row(), 0)->data(Qt::UserRole).toInt();
       if (item->checkState()) {
-        ui->wgt_gl->setEnableLight(type, item->index().row());
+        ui->wgt_gl->setEnableLight(type, handle);
       } else {
-        ui->wgt_gl->setDisableLight(type, item->index().row());
+        ui->wgt_gl->setDisableLight(type, handle);
       }
     }
   }
 }
 
-void MainWindow::SetLightInfo(QMap<QString, QVariant> light_data) {
-  for (auto &property : light_data) {
-    if (QString(property.typeName()) == "QVector3D*") {
-      if (light_data.key(property) == ".direction") {
-        ui->directionLight_x_spb->setValue(property.value<QVector3D *>()->x());
-        ui->directionLight_y_spb->setValue(property.value<QVector3D *>()->y());
-        ui->directionLight_z_spb->setValue(property.value<QVector3D *>()->z());
-      } else if (light_data.key(property) == ".position") {
-        ui->positionLight_x_spb->setValue(property.value<QVector3D *>()->x());
-        ui->positionLight_y_spb->setValue(property.value<QVector3D *>()->y());
-        ui->positionLight_z_spb->setValue(property.value<QVector3D *>()->z());
-      }
-    } else {
-      if (light_data.key(property) == ".cutOff") {
-        ui->cutLight_spb->setValue(*property.value<float *>());
-      } else if (light_data.key(property) == ".outerCutOff") {
-        ui->outerCutLight_spb->setValue(*property.value<float *>());
-      }
-    }
-  }
+void MainWindow::SetLightInfo(QVector3D direction, QVector3D position,
+                              double cut, double outer_cut) {
+  ui->directionLight_x_spb->setValue(direction.x());
+  ui->directionLight_y_spb->setValue(direction.y());
+  ui->directionLight_z_spb->setValue(direction.z());
+  ui->positionLight_x_spb->setValue(position.x());
+  ui->positionLight_y_spb->setValue(position.y());
+  ui->positionLight_z_spb->setValue(position.z());
+  ui->cutLight_spb->setValue(cut);
+  ui->outerCutLight_spb->setValue(outer_cut);
 }
 
 void MainWindow::SetCurrentLightDistance(int index) {
@@ -902,7 +970,7 @@ void MainWindow::on_btn_texture_mirrored_clicked() {
 
 void MainWindow::on_btn_surface_ambient_clicked() {
   if (obj_) {
-    Mesh *current_mesh = obj_->GetCurrentMesh();
+    MeshPart *current_mesh = obj_->GetCurrentMesh();
     QColorDialog color(this);
     if (current_mesh) {
       auto &cur_material = current_mesh->GetMaterial();
@@ -921,7 +989,7 @@ void MainWindow::on_btn_surface_ambient_clicked() {
 void MainWindow::on_btn_surface_diffuse_clicked() {
   if (obj_) {
     QColorDialog color(this);
-    Mesh *current_mesh = obj_->GetCurrentMesh();
+    MeshPart *current_mesh = obj_->GetCurrentMesh();
     if (current_mesh) {
       auto &cur_material = current_mesh->GetMaterial();
       QColor cur_color;
@@ -939,7 +1007,7 @@ void MainWindow::on_btn_surface_diffuse_clicked() {
 void MainWindow::on_btn_surface_specular_clicked() {
   if (obj_) {
     QColorDialog color(this);
-    Mesh *current_mesh = obj_->GetCurrentMesh();
+    MeshPart *current_mesh = obj_->GetCurrentMesh();
     if (current_mesh) {
       auto &cur_material = current_mesh->GetMaterial();
       QColor cur_color;
@@ -1039,4 +1107,172 @@ void MainWindow::on_error(QString msg) {
   err.exec();
 }
 
+void MainWindow::on_act_cache_enabled_triggered(bool checked) {
+  MeshCache::SetEnabled(checked);
+}
+
+void MainWindow::on_act_cache_limit_triggered() {
+  bool ok = false;
+  const int limit = QInputDialog::getInt(this, "Кэш моделей", "Размер, МБ:",
+                                         MeshCache::GetLimit(), 16, 1 << 20,
+                                         64, &ok);
+  if (ok) {
+    MeshCache::SetLimit(limit);
+  }
+}
+
+void MainWindow::on_act_cache_clear_triggered() { MeshCache::Clear(); }
+
+void MainWindow::on_act_compact_vertices_triggered(bool checked) {
+  VertexFormat::SetCompact(checked);
+}
+
+void MainWindow::on_act_split_meshes_triggered(bool checked) {
+  IndexFormat::SetSplit(checked);
+}
+
+void MainWindow::on_act_batch_meshes_triggered(bool checked) {
+  MeshBatcher::SetEnabled(checked);
+}
+
+void MainWindow::on_act_optimize_meshes_triggered(bool checked) {
+  MeshOptimizer::SetEnabled(checked);
+}
+
+void MainWindow::on_act_build_lods_triggered(bool checked) {
+  MeshSimplifier::SetEnabled(checked);
+}
+
+void MainWindow::on_act_triangle_budget_triggered() {
+  bool ok = false;
+  const int budget = QInputDialog::getInt(
+      this, "Уровни детализации", "Треугольников в кадре (0 - без ограничения):",
+      MeshSimplifier::GetBudget(), 0, 1 << 30, 100000, &ok);
+  if (ok) {
+    MeshSimplifier::SetBudget(budget);
+    ui->wgt_gl->SetTriangleBudget(budget);
+  }
+}
+
+void MainWindow::on_act_continuous_render_triggered(bool checked) {
+  ui->wgt_gl->SetContinuous(checked);
+  settings_.setSettings("continuousRender", checked);
+}
+
+void MainWindow::on_act_gpu_buffers_triggered() {
+  const QString names[] = {"Вершины", "Сжатые вершины", "Индексы",
+                           "Экземпляры"};
+  QString text;
+  for (int i = 0; i < int(ArenaBuffer::kCount); ++i) {
+    const ArenaStats stats = BufferArena::GetStats(ArenaBuffer(i));
+    text += QString("%1: %2 / %3 КБ, выделений: %4, дыр: %5, "
+                    "наибольший свободный блок: %6 КБ, "
+                    "фрагментация: %7%\n")
+                .arg(names[i])
+                .arg(stats.used / 1024)
+                .arg(stats.capacity / 1024)
+                .arg(stats.allocations)
+                .arg(stats.holes)
+                .arg(stats.largest_free / 1024)
+                .arg(stats.GetFragmentation() * 100.0, 0, 'f', 1);
+  }
+  const GeometryStats geometry = GeometryStore::GetStats();
+  text += QString("Общая геометрия: %1 из %2 мешей, треугольников: %3, "
+                  "сэкономлено: %4 КБ\n")
+              .arg(geometry.geometries)
+              .arg(geometry.references)
+              .arg(geometry.triangles)
+              .arg(geometry.saved_bytes / 1024);
+  QMessageBox box(this);
+  box.setWindowTitle("Буферы GPU");
+  box.setText(text);
+  QPushButton *defragment =
+      box.addButton("Дефрагментировать", QMessageBox::ActionRole);
+  box.addButton(QMessageBox::Close);
+  box.exec();
+  if (box.clickedButton() == defragment) {
+    ui->wgt_gl->DefragmentBuffers();
+  }
+}
+
+void MainWindow::on_act_instance_grid_triggered() {
+  if (obj_) {
+    bool ok = false;
+    const int count = QInputDialog::getInt(
+        this, "Массив копий", "Количество копий модели:",
+        obj_->GetInstanceCount(), 1, 1 << 20, 1, &ok);
+    if (ok) {
+      obj_->SetInstanceGrid(count);
+    }
+  }
+}
+
+void MainWindow::on_act_instance_color_triggered() {
+  if (obj_) {
+    QColorDialog color(Qt::white, this);
+    color.setWindowTitle("Цвет копий");
+    if (color.exec() == QColorDialog::Accepted) {
+      obj_->SetInstanceColor(color.selectedColor());
+    }
+  }
+}
+
+void MainWindow::SetLoadProgress() {
+  load_progress_ = new QProgressBar(this);
+  load_progress_->setRange(0, 1000);
+  load_progress_->setMaximumWidth(320);
+  load_progress_->hide();
+  ui->statusbar->addPermanentWidget(load_progress_);
+
+  load_cancel_ = new QPushButton("Отмена", this);
+  load_cancel_->hide();
+  ui->statusbar->addPermanentWidget(load_cancel_);
+  connect(load_cancel_, SIGNAL(clicked()), ui->wgt_gl, SLOT(CancelLoading()));
+}
+
+void MainWindow::LoadProgress(qint64 bytes, qint64 total_bytes, int meshes,
+                              int total_meshes, qint64 faces) {
+  if (total_bytes > 0) {
+    load_progress_->setValue(bytes * 1000 / total_bytes);
+  }
+  load_progress_->setFormat(
+      QString("%1 / %2 МБ, мешей: %3 / %4, полигонов: %5")
+          .arg(bytes / (1024 * 1024))
+          .arg(total_bytes / (1024 * 1024))
+          .arg(meshes)
+          .arg(total_meshes)
+          .arg(faces));
+}
+
+void MainWindow::LoadFinished() {
+  load_progress_->hide();
+  load_cancel_->hide();
+}
+
+void MainWindow::SetFrameStats() {
+  frame_stats_ = new QLabel(this);
+  ui->statusbar->addPermanentWidget(frame_stats_);
+  state_stats_ = new QLabel(this);
+  ui->statusbar->addPermanentWidget(state_stats_);
+}
+
+void MainWindow::FrameStats(qint64 clusters, qint64 frustum_culled,
+                            qint64 cone_culled, qint64 triangles) {
+  frame_stats_->setText(QString("Clusters: %1 (frustum -%2, backface -%3)  "
+                                "Drawn triangles: %4")
+                            .arg(clusters)
+                            .arg(frustum_culled)
+                            .arg(cone_culled)
+                            .arg(triangles));
+}
+
+void MainWindow::StateStats(qint64 changes, qint64 avoided,
+                            qint64 cpu_time) {
+  state_stats_->setText(QString("GL state: %1 changes, %2 skipped  "
+                                "Frame CPU: %3 us")
+                            .arg(changes)
+                            .arg(avoided)
+                            .arg(cpu_time));
+}
+
 }  // namespace s21
@@ -5,12 +5,17 @@
 #include <QColorDialog>
 #include <QFile>
 #include <QFileDialog>
+#include <QInputDialog>
+#include <QLabel>
 #include <QMainWindow>
+#include <QProgressBar>
+#include <QPushButton>
 #include <QStandardItemModel>
 #include <QThread>
 
 #include "global_settings.h"
 #include "illumination.h"
+#include "mesh_cache.h"
 #include "savior.h"
 #include "ui_mainwindow.h"
 #include "wgt_width.h"
@@ -74,7 +79,7 @@ class MainWindow : public QMainWindow {
   void on_add_point_light_btn_clicked();
   void on_add_spot_light_btn_clicked();
   void item_changed(QStandardItem *item);
-  void SetLightInfo(QMap<QString, QVariant>);
+  void SetLightInfo(QVector3D, QVector3D, double, double);
   void SetCurrentLightDistance(int);
 
   void SetSpecular(QVector3D);
@@ -106,8 +111,30 @@ class MainWindow : public QMainWindow {
 
   void on_error(QString msg);
 
+  void AddModelLable(QString);
+  void LoadProgress(qint64 bytes, qint64 total_bytes, int meshes,
+                    int total_meshes, qint64 faces);
+  void LoadFinished();
+  void FrameStats(qint64 clusters, qint64 frustum_culled, qint64 cone_culled,
+                  qint64 triangles);
+  void StateStats(qint64 changes, qint64 avoided, qint64 cpu_time);
+
   void on_act_save_file_triggered();
 
+  void on_act_cache_enabled_triggered(bool checked);
+  void on_act_cache_limit_triggered();
+  void on_act_cache_clear_triggered();
+  void on_act_compact_vertices_triggered(bool checked);
+  void on_act_split_meshes_triggered(bool checked);
+  void on_act_batch_meshes_triggered(bool checked);
+  void on_act_optimize_meshes_triggered(bool checked);
+  void on_act_build_lods_triggered(bool checked);
+  void on_act_triangle_budget_triggered();
+  void on_act_continuous_render_triggered(bool checked);
+  void on_act_gpu_buffers_triggered();
+  void on_act_instance_grid_triggered();
+  void on_act_instance_color_triggered();
+
  private:
   void keyPressEvent(QKeyEvent *event);
   void ConnectModelRegister();
@@ -117,16 +144,21 @@ class MainWindow : public QMainWindow {
   void AddLightOnTree(int);
   void SetItemList();
   void SetLightList();
-  void AddModelLable(QString);
   void SetMeshInfo();
   void SetModelInfo();
   void ShowLightSettings(const int);
   void SetLightWindow();
+  void SetLoadProgress();
+  void SetFrameStats();
 
   Ui::MainWindow *ui;
   Model *obj_;
   GlobalSetting settings_;
   QString tmp_info_string_;
+  QProgressBar *load_progress_;
+  QPushButton *load_cancel_;
+  QLabel *frame_stats_;
+  QLabel *state_stats_;
 };
 
 }  // namespace s21
@@ -0,0 +1,34 @@
+#ifndef IMPORT_PROGRESS_H_
+#define IMPORT_PROGRESS_H_
+
+#include <QtGlobal>
+#include <atomic>
+
+namespace s21 {
+
+class ImportProgress {
+ public:
+  void SetTotalBytes(qint64 bytes) { m_total_bytes_ = bytes; }
+  void SetBytes(qint64 bytes) { m_bytes_ = bytes; }
+  void AddBytes(qint64 bytes) { m_bytes_ += bytes; }
+  void SetTotalMeshes(int meshes) { m_total_meshes_ = meshes; }
+  void AddMeshes(int meshes) { m_meshes_ += meshes; }
+  void Cancel() { m_cancelled_ = true; }
+
+  qint64 GetTotalBytes() const { return m_total_bytes_; }
+  qint64 GetBytes() const { return m_bytes_; }
+  int GetTotalMeshes() const { return m_total_meshes_; }
+  int GetMeshes() const { return m_meshes_; }
+  bool IsCancelled() const { return m_cancelled_; }
+
+ private:
+  std::atomic<qint64> m_total_bytes_{0};
+  std::atomic<qint64> m_bytes_{0};
+  std::atomic<int> m_total_meshes_{0};
+  std::atomic<int> m_meshes_{0};
+  std::atomic<bool> m_cancelled_{false};
+};
+
+}  // namespace s21
+
+#endif  // IMPORT_PROGRESS_H_
@@ -0,0 +1,58 @@
+#ifndef IMPORT_STREAM_H_
+#define IMPORT_STREAM_H_
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector3D>
+#include <QVector>
+#include <atomic>
+#include <utility>
+
+namespace s21 {
+
+// Preview triangles of one parsed chunk. Every vertex is a position followed
+// by the face normal.
+struct StreamBatch {
+  QVector<float> vertices;
+  qint64 faces = 0;
+  QVector3D min_value;
+  QVector3D max_value;
+
+  StreamBatch()
+      : min_value{QVector3D(INFINITY, INFINITY, INFINITY)},
+        max_value{QVector3D(-INFINITY, -INFINITY, -INFINITY)} {}
+};
+
+// Hands preview geometry from the import threads to the GUI thread while a
+// model is still loading.
+class ImportStream {
+ public:
+  static const int kVertexSize = 6;
+  // Faces are sampled so that the whole preview stays below this.
+  static const qint64 kMaxTriangles = 1 << 21;
+
+  // The face count is bumped after the append, under the lock, so a reader
+  // that sees the new count always finds the batch in Take().
+  void Push(StreamBatch &&batch) {
+    const qint64 faces = batch.faces;
+    QMutexLocker locker(&m_mutex_);
+    m_batches_.push_back(std::move(batch));
+    m_faces_ += faces;
+  }
+
+  QVector<StreamBatch> Take() {
+    QMutexLocker locker(&m_mutex_);
+    return std::exchange(m_batches_, QVector<StreamBatch>());
+  }
+
+  qint64 GetFaces() const { return m_faces_; }
+
+ private:
+  QMutex m_mutex_;
+  QVector<StreamBatch> m_batches_;
+  std::atomic<qint64> m_faces_{0};
+};
+
+}  // namespace s21
+
+#endif  // IMPORT_STREAM_H_
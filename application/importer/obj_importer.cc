@@ -0,0 +1,724 @@
+#include "obj_importer.h"
+
+#include <QFileInfo>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+#include "parallel.h"
+
+namespace s21 {
+
+namespace {
+
+const size_t kMinChunkSize = 1 << 20;
+
+const double kPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                         1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                         1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+inline bool IsBlank(char c) { return c == ' ' || c == '\t'; }
+
+inline bool IsDigit(char c) { return static_cast<unsigned char>(c - '0') < 10; }
+
+inline const char *SkipBlanks(const char *p, const char *end) {
+  while (p < end && IsBlank(*p)) ++p;
+  return p;
+}
+
+inline const char *TrimRight(const char *begin, const char *end) {
+  while (end > begin && (IsBlank(end[-1]) || end[-1] == '\r')) --end;
+  return end;
+}
+
+inline const char *Keyword(const char *p, const char *eol, const char *word) {
+  while (*word) {
+    if (p == eol || *p != *word) return nullptr;
+    ++p;
+    ++word;
+  }
+  return (p == eol || IsBlank(*p)) ? p : nullptr;
+}
+
+template <typename Function>
+void ForEachLine(const char *begin, const char *end, Function &&function) {
+  for (const char *line = begin; line < end;) {
+    const char *eol =
+        static_cast<const char *>(std::memchr(line, '\n', end - line));
+    if (!eol) eol = end;
+    const char *p = SkipBlanks(line, eol);
+    function(p, TrimRight(p, eol));
+    line = eol + 1;
+  }
+}
+
+const char *ParseFloat(const char *p, const char *end, float &value) {
+  p = SkipBlanks(p, end);
+  const char *start = p;
+
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  bool any = false;
+  for (; p < end && IsDigit(*p); ++p) {
+    any = true;
+    if (digits < 19) {
+      mantissa = mantissa * 10 + (*p - '0');
+      digits += mantissa != 0;
+    } else {
+      ++exponent;
+    }
+  }
+  if (p < end && *p == '.') {
+    for (++p; p < end && IsDigit(*p); ++p) {
+      any = true;
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*p - '0');
+        digits += mantissa != 0;
+        --exponent;
+      }
+    }
+  }
+  if (!any) {
+    value = 0.0f;
+    return start;
+  }
+
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    const char *q = p + 1;
+    bool exp_negative = false;
+    if (q < end && (*q == '-' || *q == '+')) {
+      exp_negative = *q == '-';
+      ++q;
+    }
+    if (q < end && IsDigit(*q)) {
+      int exp_value = 0;
+      for (; q < end && IsDigit(*q); ++q) {
+        if (exp_value < 10000) exp_value = exp_value * 10 + (*q - '0');
+      }
+      exponent += exp_negative ? -exp_value : exp_value;
+      p = q;
+    }
+  }
+
+  double result = static_cast<double>(mantissa);
+  if (mantissa != 0 && exponent != 0) {
+    if (exponent < 0 && exponent >= -22) {
+      result /= kPow10[-exponent];
+    } else if (exponent > 0 && exponent <= 22) {
+      result *= kPow10[exponent];
+    } else {
+      result *= std::pow(10.0, exponent);
+    }
+  }
+  value = static_cast<float>(negative ? -result : result);
+  return p;
+}
+
+const char *ParseInt(const char *p, const char *end, int &value) {
+  const char *start = p;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+  if (p == end || !IsDigit(*p)) {
+    value = 0;
+    return start;
+  }
+  long long result = 0;
+  for (; p < end && IsDigit(*p); ++p) {
+    if (result < INT32_MAX) result = result * 10 + (*p - '0');
+  }
+  value = static_cast<int>(negative ? -result : result);
+  return p;
+}
+
+inline int ResolveIndex(int value, size_t count) {
+  if (value > 0) return value - 1;
+  if (value < 0) return static_cast<int>(static_cast<long long>(count) + value);
+  return -1;
+}
+
+QVector3D ReadVector(const float *data, int index) {
+  return QVector3D(data[3 * index], data[3 * index + 1], data[3 * index + 2]);
+}
+
+QString ReadTexturePath(const char *p, const char *eol) {
+  p = SkipBlanks(p, eol);
+  while (p < eol && *p == '-') {
+    while (p < eol && !IsBlank(*p)) ++p;
+    p = SkipBlanks(p, eol);
+    float value;
+    for (const char *next = ParseFloat(p, eol, value);
+         next != p && (next == eol || IsBlank(*next));
+         next = ParseFloat(p, eol, value)) {
+      p = SkipBlanks(next, eol);
+    }
+  }
+  return QString::fromUtf8(p, eol - p);
+}
+
+struct VertexKey {
+  int position;
+  int uv;
+  int normal;
+  quint32 generated[3];
+
+  bool operator==(const VertexKey &other) const {
+    return position == other.position && uv == other.uv &&
+           normal == other.normal &&
+           std::memcmp(generated, other.generated, sizeof(generated)) == 0;
+  }
+};
+
+struct VertexKeyHash {
+  size_t operator()(const VertexKey &key) const {
+    uint64_t hash =
+        static_cast<uint32_t>(key.position) * 0x9E3779B97F4A7C15ull;
+    hash ^= (static_cast<uint32_t>(key.uv) + 0x7F4A7C15ull) *
+            0xBF58476D1CE4E5B9ull;
+    hash ^= (static_cast<uint32_t>(key.normal) + 0x1CE4E5B9ull) *
+            0x94D049BB133111EBull;
+    hash ^= key.generated[0] ^
+            (static_cast<uint64_t>(key.generated[1]) << 21) ^
+            (static_cast<uint64_t>(key.generated[2]) << 42);
+    return static_cast<size_t>(hash ^ (hash >> 31));
+  }
+};
+
+}  // namespace
+
+ObjImporter::ObjImporter(QString path)
+    : m_path_{path}, m_directory_(path), m_file_(path) {
+  m_directory_.cdUp();
+}
+
+bool ObjImporter::CanRead(const QString &path) {
+  return QFileInfo(path).suffix().toLower() == "obj";
+}
+
+QString ObjImporter::GetError() const { return m_error_; }
+
+void ObjImporter::SetTextureCallback(
+    std::function<void(const QString &)> callback) {
+  m_texture_callback_ = std::move(callback);
+}
+
+void ObjImporter::SetStream(ImportStream *stream) { m_stream_ = stream; }
+
+bool ObjImporter::Read(QVector<MeshData> &meshes, ImportProgress &progress) {
+  if (!m_file_.open(QIODevice::ReadOnly)) {
+    m_error_ = "ERROR::OBJ::" + m_file_.errorString();
+    return false;
+  }
+
+  const size_t size = m_file_.size();
+  const char *data = nullptr;
+  if (size) {
+    data = reinterpret_cast<const char *>(m_file_.map(0, size));
+    if (!data) {
+      m_buffer_ = m_file_.readAll();
+      data = m_buffer_.constData();
+    }
+  }
+  if (!data) {
+    m_error_ = "ERROR::OBJ::empty file " + m_path_;
+    return false;
+  }
+
+  progress.SetTotalBytes(size);
+  SplitChunks(data, size);
+  ParallelFor(m_chunks_.size(), [this, &progress](size_t i) {
+    if (!progress.IsCancelled()) CountElements(m_chunks_[i]);
+  });
+  if (progress.IsCancelled()) {
+    return false;
+  }
+
+  for (auto &chunk : m_chunks_) {
+    for (auto &it : chunk.libraries) {
+      LoadMaterialLibrary(it);
+    }
+  }
+  if (m_texture_callback_) {
+    for (auto &material : m_materials_) {
+      for (auto &it : material.textures) {
+        m_texture_callback_(m_directory_.filePath(it.path));
+      }
+    }
+  }
+
+  size_t positions = 0, normals = 0, uvs = 0, faces = 0;
+  for (auto &it : m_chunks_) {
+    it.position_base = positions;
+    it.normal_base = normals;
+    it.uv_base = uvs;
+    it.face_base = faces;
+    positions += it.position_count;
+    normals += it.normal_count;
+    uvs += it.uv_count;
+    faces += it.face_count;
+  }
+  m_positions_.resize(3 * positions);
+  m_normals_.resize(3 * normals);
+  m_uvs_.resize(2 * uvs);
+  m_stream_stride_ = faces / ImportStream::kMaxTriangles + 1;
+  m_parsed_.assign(m_chunks_.size(), 0);
+
+  ParallelFor(m_chunks_.size(), [this, &progress](size_t i) {
+    if (progress.IsCancelled()) return;
+    ParseChunk(m_chunks_[i]);
+    progress.AddBytes(m_chunks_[i].end - m_chunks_[i].begin);
+    if (m_stream_) StreamParsed(i);
+  });
+  if (progress.IsCancelled()) {
+    return false;
+  }
+
+  const std::vector<Group> groups = GroupFaces();
+  if (groups.empty()) {
+    m_error_ = "ERROR::OBJ::no faces in " + m_path_;
+    return false;
+  }
+
+  progress.SetTotalMeshes(groups.size());
+  QVector<MeshData> result(groups.size());
+  std::vector<char> status(groups.size(), 0);
+  ParallelFor(groups.size(), [&](size_t i) {
+    if (progress.IsCancelled()) return;
+    status[i] = BuildMesh(groups[i], result[i]);
+    progress.AddMeshes(1);
+  });
+  if (progress.IsCancelled()) {
+    return false;
+  }
+  for (auto it : status) {
+    if (!it) {
+      m_error_ = "ERROR::OBJ::invalid face index in " + m_path_;
+      return false;
+    }
+  }
+
+  meshes = std::move(result);
+  return true;
+}
+
+void ObjImporter::SplitChunks(const char *data, size_t size) {
+  const size_t chunk_size = std::max(kMinChunkSize, size / (4 * WorkerCount()));
+  const char *end = data + size;
+  for (const char *begin = data; begin < end;) {
+    const char *cut = begin + std::min(chunk_size, size_t(end - begin));
+    if (cut < end) {
+      const char *eol =
+          static_cast<const char *>(std::memchr(cut, '\n', end - cut));
+      cut = eol ? eol + 1 : end;
+    }
+    Chunk chunk;
+    chunk.begin = begin;
+    chunk.end = cut;
+    m_chunks_.push_back(std::move(chunk));
+    begin = cut;
+  }
+}
+
+void ObjImporter::CountElements(Chunk &chunk) const {
+  ForEachLine(chunk.begin, chunk.end, [&chunk](const char *p, const char *eol) {
+    if (p == eol) return;
+    const char *q = nullptr;
+    if (*p == 'v') {
+      if (Keyword(p, eol, "v")) {
+        ++chunk.position_count;
+      } else if (Keyword(p, eol, "vn")) {
+        ++chunk.normal_count;
+      } else if (Keyword(p, eol, "vt")) {
+        ++chunk.uv_count;
+      }
+    } else if (Keyword(p, eol, "f")) {
+      ++chunk.face_count;
+    } else if ((q = Keyword(p, eol, "mtllib"))) {
+      q = SkipBlanks(q, eol);
+      chunk.libraries << QString::fromUtf8(q, eol - q);
+    }
+  });
+}
+
+void ObjImporter::ParseChunk(Chunk &chunk) {
+  size_t positions = chunk.position_base;
+  size_t normals = chunk.normal_base;
+  size_t uvs = chunk.uv_base;
+
+  chunk.face_offsets.push_back(0);
+  chunk.segments.push_back(Segment());
+
+  auto new_segment = [&chunk]() -> Segment & {
+    const size_t faces = chunk.face_offsets.size() - 1;
+    if (chunk.segments.back().first_face != faces) {
+      Segment segment = chunk.segments.back();
+      segment.first_face = faces;
+      chunk.segments.push_back(segment);
+    }
+    return chunk.segments.back();
+  };
+
+  ForEachLine(chunk.begin, chunk.end, [&](const char *p, const char *eol) {
+    if (p == eol) return;
+    const char *q = nullptr;
+    if (*p == 'v') {
+      if ((q = Keyword(p, eol, "v"))) {
+        float *out = &m_positions_[3 * positions++];
+        q = ParseFloat(q, eol, out[0]);
+        q = ParseFloat(q, eol, out[1]);
+        ParseFloat(q, eol, out[2]);
+      } else if ((q = Keyword(p, eol, "vn"))) {
+        float *out = &m_normals_[3 * normals++];
+        q = ParseFloat(q, eol, out[0]);
+        q = ParseFloat(q, eol, out[1]);
+        ParseFloat(q, eol, out[2]);
+      } else if ((q = Keyword(p, eol, "vt"))) {
+        float *out = &m_uvs_[2 * uvs++];
+        q = ParseFloat(q, eol, out[0]);
+        ParseFloat(q, eol, out[1]);
+      }
+    } else if ((q = Keyword(p, eol, "f"))) {
+      ParseFace(chunk, q, eol, positions, uvs, normals);
+    } else if ((q = Keyword(p, eol, "o")) || (q = Keyword(p, eol, "g"))) {
+      q = SkipBlanks(q, eol);
+      Segment &segment = new_segment();
+      segment.object = QByteArray(q, eol - q);
+      segment.has_object = true;
+    } else if ((q = Keyword(p, eol, "usemtl"))) {
+      q = SkipBlanks(q, eol);
+      Segment &segment = new_segment();
+      segment.material = QByteArray(q, eol - q);
+      segment.has_material = true;
+    }
+  });
+}
+
+void ObjImporter::ParseFace(Chunk &chunk, const char *p, const char *eol,
+                            size_t positions, size_t uvs, size_t normals) {
+  const size_t first = chunk.corners.size();
+  for (p = SkipBlanks(p, eol); p < eol; p = SkipBlanks(p, eol)) {
+    Corner corner{-1, -1, -1};
+    int value = 0;
+    const char *next = ParseInt(p, eol, value);
+    if (next == p) break;
+    corner.position = ResolveIndex(value, positions);
+    p = next;
+    if (p < eol && *p == '/') {
+      ++p;
+      if (p < eol && *p != '/') {
+        p = ParseInt(p, eol, value);
+        corner.uv = ResolveIndex(value, uvs);
+      }
+      if (p < eol && *p == '/') {
+        p = ParseInt(p + 1, eol, value);
+        corner.normal = ResolveIndex(value, normals);
+      }
+    }
+    chunk.corners.push_back(corner);
+    while (p < eol && !IsBlank(*p)) ++p;
+  }
+
+  if (chunk.corners.size() - first >= 3) {
+    chunk.face_offsets.push_back(chunk.corners.size());
+  } else {
+    chunk.corners.resize(first);
+  }
+}
+
+void ObjImporter::LoadMaterialLibrary(const QString &name) {
+  QFile file(m_directory_.filePath(name));
+  if (!file.open(QIODevice::ReadOnly)) return;
+  const QByteArray content = file.readAll();
+
+  ObjMaterial *current = nullptr;
+  ForEachLine(content.constData(), content.constData() + content.size(),
+              [&](const char *p, const char *eol) {
+                if (p == eol || *p == '#') return;
+                const char *q = nullptr;
+                if ((q = Keyword(p, eol, "newmtl"))) {
+                  q = SkipBlanks(q, eol);
+                  current = &m_materials_[QByteArray(q, eol - q)];
+                  return;
+                }
+                if (!current) return;
+
+                Material &material = current->material;
+                float x = 0.0f, y = 0.0f, z = 0.0f;
+                auto read_color = [&](const char *q) {
+                  q = ParseFloat(q, eol, x);
+                  q = ParseFloat(q, eol, y);
+                  ParseFloat(q, eol, z);
+                  return QVector3D(x, y, z);
+                };
+                if ((q = Keyword(p, eol, "Ka"))) {
+                  material.Ka = read_color(q);
+                } else if ((q = Keyword(p, eol, "Kd"))) {
+                  material.Kd = read_color(q);
+                } else if ((q = Keyword(p, eol, "Ks"))) {
+                  material.Ks = read_color(q);
+                } else if ((q = Keyword(p, eol, "Ke"))) {
+                  material.Ke = read_color(q);
+                } else if ((q = Keyword(p, eol, "Ns"))) {
+                  ParseFloat(q, eol, material.Ns);
+                } else if ((q = Keyword(p, eol, "Ni"))) {
+                  ParseFloat(q, eol, material.Ni);
+                } else if ((q = Keyword(p, eol, "d"))) {
+                  ParseFloat(q, eol, material.d);
+                } else if ((q = Keyword(p, eol, "Tr"))) {
+                  ParseFloat(q, eol, x);
+                  material.d = 1.0f - x;
+                } else if ((q = Keyword(p, eol, "illum"))) {
+                  ParseFloat(q, eol, x);
+                  material.illum = static_cast<unsigned int>(x);
+                } else if ((q = Keyword(p, eol, "map_Ka"))) {
+                  current->textures.push_back(
+                      {"texture_ambient", ReadTexturePath(q, eol)});
+                } else if ((q = Keyword(p, eol, "map_Kd"))) {
+                  current->textures.push_back(
+                      {"texture_diffuse", ReadTexturePath(q, eol)});
+                } else if ((q = Keyword(p, eol, "map_Ks"))) {
+                  current->textures.push_back(
+                      {"texture_specular", ReadTexturePath(q, eol)});
+                } else if ((q = Keyword(p, eol, "map_Bump")) ||
+                           (q = Keyword(p, eol, "map_bump")) ||
+                           (q = Keyword(p, eol, "bump"))) {
+                  current->textures.push_back(
+                      {"texture_normal", ReadTexturePath(q, eol)});
+                }
+              });
+}
+
+void ObjImporter::StreamParsed(size_t index) {
+  size_t first = 0, last = 0;
+  {
+    QMutexLocker locker(&m_stream_mutex_);
+    m_parsed_[index] = 1;
+    first = m_stream_cursor_;
+    while (m_stream_cursor_ < m_parsed_.size() &&
+           m_parsed_[m_stream_cursor_]) {
+      ++m_stream_cursor_;
+    }
+    last = m_stream_cursor_;
+  }
+  for (size_t i = first; i < last; ++i) {
+    m_stream_->Push(BuildPreview(m_chunks_[i]));
+  }
+}
+
+StreamBatch ObjImporter::BuildPreview(const Chunk &chunk) const {
+  StreamBatch batch;
+  const int parsed = static_cast<int>(chunk.position_base +
+                                      chunk.position_count);
+  const size_t faces = chunk.face_offsets.size() - 1;
+  batch.faces = faces;
+
+  float *out = nullptr;
+  for (size_t face = 0; face < faces; ++face) {
+    if ((chunk.face_base + face) % m_stream_stride_) continue;
+    const Corner *corners = chunk.corners.data() + chunk.face_offsets[face];
+    const size_t count =
+        chunk.face_offsets[face + 1] - chunk.face_offsets[face];
+    bool valid = true;
+    for (size_t i = 0; i < count; ++i) {
+      valid &= corners[i].position >= 0 && corners[i].position < parsed;
+    }
+    if (!valid) continue;
+
+    const QVector3D a = ReadVector(m_positions_.data(), corners[0].position);
+    for (size_t i = 1; i + 1 < count; ++i) {
+      const QVector3D b = ReadVector(m_positions_.data(), corners[i].position);
+      const QVector3D c =
+          ReadVector(m_positions_.data(), corners[i + 1].position);
+      const QVector3D normal = QVector3D::normal(b - a, c - a);
+      const int size = batch.vertices.size();
+      batch.vertices.resize(size + 3 * ImportStream::kVertexSize);
+      out = batch.vertices.data() + size;
+      for (const QVector3D &it : {a, b, c}) {
+        for (int j = 0; j < 3; ++j) {
+          *out++ = it[j];
+          batch.min_value[j] = std::min(batch.min_value[j], it[j]);
+          batch.max_value[j] = std::max(batch.max_value[j], it[j]);
+        }
+        for (int j = 0; j < 3; ++j) {
+          *out++ = normal[j];
+        }
+      }
+    }
+  }
+  return batch;
+}
+
+std::vector<ObjImporter::Group> ObjImporter::GroupFaces() const {
+  std::vector<Group> groups;
+  QHash<QByteArray, size_t> index;
+
+  QByteArray object, material;
+  for (auto &chunk : m_chunks_) {
+    const size_t faces = chunk.face_offsets.size() - 1;
+    for (size_t i = 0; i < chunk.segments.size(); ++i) {
+      const Segment &segment = chunk.segments[i];
+      if (segment.has_object) object = segment.object;
+      if (segment.has_material) material = segment.material;
+
+      const size_t last = (i + 1 < chunk.segments.size())
+                              ? chunk.segments[i + 1].first_face
+                              : faces;
+      if (last <= segment.first_face) continue;
+
+      QByteArray key = object;
+      key.append('\0').append(material);
+      auto it = index.find(key);
+      if (it == index.end()) {
+        it = index.insert(key, groups.size());
+        groups.push_back(Group{object, material, {}});
+      }
+      groups[it.value()].ranges.push_back(
+          FaceRange{&chunk, segment.first_face, last});
+    }
+  }
+  return groups;
+}
+
+bool ObjImporter::BuildMesh(const Group &group, MeshData &mesh) const {
+  const int position_count = static_cast<int>(m_positions_.size() / 3);
+  const int normal_count = static_cast<int>(m_normals_.size() / 3);
+  const int uv_count = static_cast<int>(m_uvs_.size() / 2);
+
+  size_t corner_total = 0, triangle_total = 0;
+  for (auto &range : group.ranges) {
+    const auto &offsets = range.chunk->face_offsets;
+    corner_total += offsets[range.last] - offsets[range.first];
+    triangle_total += offsets[range.last] - offsets[range.first] -
+                      2 * (range.last - range.first);
+  }
+
+  std::unordered_map<VertexKey, unsigned int, VertexKeyHash> lookup;
+  lookup.reserve(corner_total);
+  std::vector<int> raw_uvs;
+  raw_uvs.reserve(corner_total);
+  mesh.vertices.reserve(corner_total);
+  mesh.indices.reserve(3 * triangle_total);
+
+  bool has_uvs = false;
+  std::vector<unsigned int> polygon;
+  for (auto &range : group.ranges) {
+    const Chunk &chunk = *range.chunk;
+    for (size_t face = range.first; face < range.last; ++face) {
+      const Corner *corners = chunk.corners.data() + chunk.face_offsets[face];
+      const size_t count =
+          chunk.face_offsets[face + 1] - chunk.face_offsets[face];
+
+      for (size_t i = 0; i < count; ++i) {
+        const Corner &c = corners[i];
+        if (c.position < 0 || c.position >= position_count ||
+            c.uv >= uv_count || c.normal >= normal_count) {
+          return false;
+        }
+      }
+
+      QVector3D face_normal;
+      for (size_t i = 0; i < count; ++i) {
+        if (corners[i].normal >= 0) continue;
+        for (size_t j = 0; j < count; ++j) {
+          const QVector3D a =
+              ReadVector(m_positions_.data(), corners[j].position);
+          const QVector3D b = ReadVector(m_positions_.data(),
+                                         corners[(j + 1) % count].position);
+          face_normal += QVector3D((a.y() - b.y()) * (a.z() + b.z()),
+                                   (a.z() - b.z()) * (a.x() + b.x()),
+                                   (a.x() - b.x()) * (a.y() + b.y()));
+        }
+        face_normal.normalize();
+        break;
+      }
+
+      polygon.clear();
+      for (size_t i = 0; i < count; ++i) {
+        const Corner &c = corners[i];
+        VertexKey key{c.position, c.uv, c.normal, {0, 0, 0}};
+        if (c.normal < 0) {
+          std::memcpy(key.generated, &face_normal[0], sizeof(key.generated));
+        }
+
+        auto found = lookup.find(key);
+        if (found == lookup.end()) {
+          Vertex vertex;
+          vertex.Position = ReadVector(m_positions_.data(), c.position);
+          vertex.Normal = (c.normal >= 0)
+                              ? ReadVector(m_normals_.data(), c.normal)
+                              : face_normal;
+          if (c.uv >= 0) {
+            vertex.TexCoords =
+                QVector2D(m_uvs_[2 * c.uv], 1.0f - m_uvs_[2 * c.uv + 1]);
+            has_uvs = true;
+          }
+          for (int j = 0; j < 3; ++j) {
+            mesh.min_value[j] = std::min(mesh.min_value[j], vertex.Position[j]);
+            mesh.max_value[j] = std::max(mesh.max_value[j], vertex.Position[j]);
+          }
+          found = lookup.emplace(key, mesh.vertices.size()).first;
+          mesh.vertices.push_back(vertex);
+          raw_uvs.push_back(c.uv);
+        }
+        polygon.push_back(found->second);
+      }
+
+      for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+        mesh.indices.push_back(polygon[0]);
+        mesh.indices.push_back(polygon[i]);
+        mesh.indices.push_back(polygon[i + 1]);
+      }
+    }
+  }
+
+  if (has_uvs) {
+    for (int i = 0; i + 2 < mesh.indices.size(); i += 3) {
+      Vertex *v[3];
+      QVector2D uv[3];
+      for (int j = 0; j < 3; ++j) {
+        v[j] = &mesh.vertices[mesh.indices[i + j]];
+        const int raw = raw_uvs[mesh.indices[i + j]];
+        if (raw >= 0) uv[j] = QVector2D(m_uvs_[2 * raw], m_uvs_[2 * raw + 1]);
+      }
+      const QVector3D e1 = v[1]->Position - v[0]->Position;
+      const QVector3D e2 = v[2]->Position - v[0]->Position;
+      const float du1 = uv[1].x() - uv[0].x(), dv1 = uv[1].y() - uv[0].y();
+      const float du2 = uv[2].x() - uv[0].x(), dv2 = uv[2].y() - uv[0].y();
+      const float det = du1 * dv2 - du2 * dv1;
+      if (std::fabs(det) < 1e-12f) continue;
+
+      const float r = 1.0f / det;
+      const QVector3D tangent = (e1 * dv2 - e2 * dv1) * r;
+      const QVector3D bitangent = (e2 * du1 - e1 * du2) * r;
+      for (int j = 0; j < 3; ++j) {
+        v[j]->Tangent += tangent;
+        v[j]->Bitangent += bitangent;
+      }
+    }
+    for (auto &it : mesh.vertices) {
+      it.Tangent -= it.Normal * QVector3D::dotProduct(it.Normal, it.Tangent);
+      it.Tangent.normalize();
+      it.Bitangent.normalize();
+    }
+  }
+
+  const ObjMaterial material = m_materials_.value(group.material);
+  mesh.name = QString::fromUtf8(group.object);
+  if (mesh.name.isEmpty()) {
+    mesh.name = QFileInfo(m_path_).completeBaseName();
+  }
+  mesh.material = material.material;
+  mesh.textures = material.textures;
+  return true;
+}
+
+}  // namespace s21
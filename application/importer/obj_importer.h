@@ -0,0 +1,118 @@
+#ifndef OBJ_IMPORTER_H_
+#define OBJ_IMPORTER_H_
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <functional>
+#include <vector>
+
+#include "import_progress.h"
+#include "import_stream.h"
+#include "mesh_data.h"
+
+namespace s21 {
+
+class ObjImporter {
+ public:
+  explicit ObjImporter(QString path);
+
+  static bool CanRead(const QString &path);
+
+  bool Read(QVector<MeshData> &meshes, ImportProgress &progress);
+  QString GetError() const;
+  void SetTextureCallback(std::function<void(const QString &)> callback);
+  // Pushes a sampled preview of every chunk, in file order, as soon as it
+  // and all chunks before it are parsed.
+  void SetStream(ImportStream *stream);
+
+ private:
+  struct Corner {
+    int position;
+    int uv;
+    int normal;
+  };
+
+  struct Segment {
+    QByteArray object;
+    QByteArray material;
+    bool has_object = false;
+    bool has_material = false;
+    size_t first_face = 0;
+  };
+
+  struct Chunk {
+    const char *begin = nullptr;
+    const char *end = nullptr;
+
+    size_t position_count = 0;
+    size_t normal_count = 0;
+    size_t uv_count = 0;
+    size_t face_count = 0;
+    size_t position_base = 0;
+    size_t normal_base = 0;
+    size_t uv_base = 0;
+    size_t face_base = 0;
+
+    std::vector<Corner> corners;
+    std::vector<size_t> face_offsets;
+    std::vector<Segment> segments;
+    QStringList libraries;
+  };
+
+  struct FaceRange {
+    const Chunk *chunk;
+    size_t first;
+    size_t last;
+  };
+
+  struct Group {
+    QByteArray object;
+    QByteArray material;
+    std::vector<FaceRange> ranges;
+  };
+
+  struct ObjMaterial {
+    Material material;
+    QVector<TextureRef> textures;
+  };
+
+  void SplitChunks(const char *data, size_t size);
+  void CountElements(Chunk &chunk) const;
+  void ParseChunk(Chunk &chunk);
+  void ParseFace(Chunk &chunk, const char *p, const char *eol,
+                 size_t positions, size_t uvs, size_t normals);
+  void LoadMaterialLibrary(const QString &name);
+  void StreamParsed(size_t index);
+  StreamBatch BuildPreview(const Chunk &chunk) const;
+  std::vector<Group> GroupFaces() const;
+  bool BuildMesh(const Group &group, MeshData &mesh) const;
+
+  QString m_path_;
+  QDir m_directory_;
+  QString m_error_;
+
+  QFile m_file_;
+  QByteArray m_buffer_;
+
+  std::vector<Chunk> m_chunks_;
+  std::vector<float> m_positions_;
+  std::vector<float> m_normals_;
+  std::vector<float> m_uvs_;
+  QHash<QByteArray, ObjMaterial> m_materials_;
+  std::function<void(const QString &)> m_texture_callback_;
+
+  ImportStream *m_stream_ = nullptr;
+  size_t m_stream_stride_ = 1;
+  size_t m_stream_cursor_ = 0;
+  std::vector<char> m_parsed_;
+  QMutex m_stream_mutex_;
+};
+
+}  // namespace s21
+
+#endif  // OBJ_IMPORTER_H_
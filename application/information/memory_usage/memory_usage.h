@@ -0,0 +1,40 @@
+#ifndef MEMORY_USAGE_H_
+#define MEMORY_USAGE_H_
+
+#include <QtGlobal>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+// windows.h must come first
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace s21 {
+
+// Peak resident set size of the process in bytes, 0 if unknown.
+inline qint64 PeakMemoryUsage() {
+#if defined(Q_OS_WIN)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                               sizeof(counters))) {
+    return 0;
+  }
+  return counters.PeakWorkingSetSize;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#if defined(Q_OS_MACOS)
+  return usage.ru_maxrss;
+#else
+  return qint64(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+}  // namespace s21
+
+#endif  // MEMORY_USAGE_H_
@@ -2,14 +2,45 @@
 #define MESH_INFORMATION_H_
 
 #include <QString>
+#include <QtGlobal>
 
 namespace s21 {
 
+struct VertexCacheStats {
+  qint64 triangles = 0;
+  qint64 vertices = 0;
+  qint64 misses = 0;
+
+  void Add(const VertexCacheStats &other) {
+    triangles += other.triangles;
+    vertices += other.vertices;
+    misses += other.misses;
+  }
+
+  double GetAcmr() const { return triangles ? double(misses) / triangles : 0; }
+
+  double GetAtvr() const { return vertices ? double(misses) / vertices : 0; }
+};
+
+struct ClusterStats {
+  qint64 clusters = 0;
+  qint64 frustum_culled = 0;
+  qint64 cone_culled = 0;
+  qint64 triangles = 0;
+};
+
 struct MeshInfo {
   QString name;
 
   unsigned int vertices_count;
   unsigned int face_count;
+  qint64 vertex_bytes = 0;
+  qint64 index_bytes = 0;
+  qint64 lod_bytes = 0;
+  int lod_count = 1;
+  quint64 hash = 0;
+  // The geometry was already in the GeometryStore and was not uploaded.
+  bool shared = false;
 };
 
 }  // namespace s21
@@ -17,6 +17,18 @@ struct ModelInfo {
   unsigned int vertices_count = 0;
   unsigned int face_count = 0;
 
+  qint64 vertex_bytes = 0;
+  qint64 index_bytes = 0;
+  qint64 lod_bytes = 0;
+  qint64 peak_memory = 0;
+  // Faces of the distinct geometry, and the bytes not uploaded because the
+  // GeometryStore already held the geometry of a mesh.
+  qint64 unique_faces = 0;
+  qint64 shared_bytes = 0;
+
+  VertexCacheStats cache_stats;
+  VertexCacheStats cache_stats_before;
+
  public:
   QVector3D min_value;
   QVector3D max_value;
@@ -24,7 +36,6 @@ struct ModelInfo {
   QMatrix4x4 m_matrix;
 
   QVector<Mesh *> m_meshes;
-  QVector<Texture *> textures;
 
   explicit ModelInfo(QString name)
       : kName{name},
@@ -66,6 +77,42 @@ struct ModelInfo {
   unsigned int GetVerticeCount() const { return vertices_count; }
 
   unsigned int GetFaceCount() const { return face_count; }
+
+  void AddVertexBytes(qint64 bytes) { vertex_bytes += bytes; }
+
+  qint64 GetVertexBytes() const { return vertex_bytes; }
+
+  void AddIndexBytes(qint64 bytes) { index_bytes += bytes; }
+
+  qint64 GetIndexBytes() const { return index_bytes; }
+
+  void AddLodBytes(qint64 bytes) { lod_bytes += bytes; }
+
+  qint64 GetLodBytes() const { return lod_bytes; }
+
+  void AddUniqueFaces(qint64 count) { unique_faces += count; }
+
+  qint64 GetUniqueFaces() const { return unique_faces; }
+
+  void AddSharedBytes(qint64 bytes) { shared_bytes += bytes; }
+
+  qint64 GetSharedBytes() const { return shared_bytes; }
+
+  void SetCacheStats(const VertexCacheStats &stats) { cache_stats = stats; }
+
+  const VertexCacheStats &GetCacheStats() const { return cache_stats; }
+
+  void SetCacheStatsBefore(const VertexCacheStats &stats) {
+    cache_stats_before = stats;
+  }
+
+  const VertexCacheStats &GetCacheStatsBefore() const {
+    return cache_stats_before;
+  }
+
+  void SetPeakMemory(qint64 bytes) { peak_memory = bytes; }
+
+  qint64 GetPeakMemory() const { return peak_memory; }
 };
 
 }  // namespace s21
@@ -1,193 +1,265 @@
 #include "illumination.h"
 
 namespace s21 {
-Illumination::Illumination()
-    : currentItem_{nullptr},
-      dirLights_{new QVector<QVariant>()},
-      pointLights_{new QVector<QVariant>()},
-      spotLights_{new QVector<QVariant>()},
-      illumination_{{"dirLight", dirLights_},
-                    {"pointLight", pointLights_},
-                    {"spotLight", spotLights_}},
-      current_light_{"dirLight", 0}
-
-{
-  addLight("dirLight");
-  emit CurrentLightInfo(GetLightInfo());
-}
-
-Illumination::~Illumination() {
-  for (auto &it : illumination_) {
-    for ([[maybe_unused]] auto &item : *it) {
-      RemoveLight(illumination_.key(it), 0);
+
+namespace {
+
+// Constant, linear and quadratic attenuation for the ranges offered in the
+// light panel, nearest first.
+const QVector3D kDistances[] = {
+    {1.f, 0.7f, 1.8f},      {1.f, 0.35f, 0.54f},    {1.f, 0.22f, 0.2f},
+    {1.f, 0.14f, 0.07f},    {1.f, 0.09f, 0.032f},   {1.f, 0.07f, 0.017f},
+    {1.f, 0.045f, 0.0075f}, {1.f, 0.027f, 0.0028f}, {1.f, 0.022f, 0.0019f},
+    {1.f, 0.014f, 0.0007f}, {1.f, 0.007f, 0.0002f}, {1.f, 0.0014f, 0.000007f}};
+const int kDistanceCount = sizeof(kDistances) / sizeof(kDistances[0]);
+
+template <class T>
+void SetAttenuation(T &light, int index) {
+  light.constant = kDistances[index].x();
+  light.linear = kDistances[index].y();
+  light.quadratic = kDistances[index].z();
+}
+
+template <class T>
+int FindDistance(const T &light) {
+  for (int i = 0; i < kDistanceCount; ++i) {
+    if (light.linear == kDistances[i].y() &&
+        light.quadratic == kDistances[i].z()) {
+      return i;
     }
-    delete it;
   }
+  return kDistanceCount - 1;
 }
 
-void Illumination::addLight(QString type) {
+}  // namespace
+
+Illumination::Illumination() { dir_lights_.Add(); }
+
+int Illumination::addLight(QString type) {
   if (type == "dirLight") {
-    illumination_.value(type)->append(QVariant::fromValue(new Light()));
+    return dir_lights_.Add();
   } else if (type == "pointLight") {
-    illumination_.value(type)->append(QVariant::fromValue(new PointLight()));
+    return point_lights_.Add();
   } else if (type == "spotLight") {
-    illumination_.value(type)->append(QVariant::fromValue(new SpotLight()));
+    return spot_lights_.Add();
   }
+  return -1;
 }
 
-QMap<QString, QVariant> &Illumination::GetLightInfo() {
-  return GetLightInfo(current_light_.first, current_light_.second);
+Illumination::Kind Illumination::KindOf(const QString &type) {
+  if (type == "pointLight") {
+    return Kind::kPoint;
+  } else if (type == "spotLight") {
+    return Kind::kSpot;
+  }
+  return Kind::kDir;
 }
 
-QMap<QString, QVariant> &Illumination::GetLightInfo(QString type, int index) {
-  QVariant item = illumination_.value(type)->at(index);
-  QString type_item = item.metaType().name();
-
-  if (type_item == "s21::PointLight*") {
-    return item.value<PointLight *>()->GetInfo();
-  } else if (type_item == "s21::SpotLight*") {
-    return item.value<SpotLight *>()->GetInfo();
+bool Illumination::Contains(Kind kind, int handle) const {
+  switch (kind) {
+    case Kind::kPoint:
+      return point_lights_.Contains(handle);
+    case Kind::kSpot:
+      return spot_lights_.Contains(handle);
+    default:
+      return dir_lights_.Contains(handle);
   }
-  return item.value<Light *>()->GetInfo();
-}
-
-void Illumination::RemoveLight(QString type, int index) {
-  QVariant item = illumination_.value(type)->at(index);
-  QString type_item = item.metaType().name();
-  if (type_item == "s21::Light*") {
-    illumination_.value(type)->remove(index);
-    delete item.value<Light *>();
-  } else if (type_item == "s21::PointLight*") {
-    illumination_.value(type)->remove(index);
-    delete item.value<PointLight *>();
-  } else if (type_item == "s21::SpotLight*") {
-    illumination_.value(type)->remove(index);
-    delete item.value<SpotLight *>();
+}
+
+template <class F>
+const F *Illumination::Field(F Light::*dir, F PointLight::*point,
+                             F SpotLight::*spot) const {
+  if (!Contains(current_kind_, current_handle_)) return nullptr;
+  switch (current_kind_) {
+    case Kind::kPoint:
+      return point ? &(point_lights_.Get(current_handle_).*point) : nullptr;
+    case Kind::kSpot:
+      return spot ? &(spot_lights_.Get(current_handle_).*spot) : nullptr;
+    default:
+      return dir ? &(dir_lights_.Get(current_handle_).*dir) : nullptr;
   }
 }
 
-bool Illumination::ItemIsActive(QVariant &item) {
-  bool status = true;
-  QString type_item = item.typeName();
-  if (type_item == "s21::Light*") {
-    status = item.value<Light *>()->isActive();
-  } else if (type_item == "s21::PointLight*") {
-    status = item.value<PointLight *>()->isActive();
-  } else if (type_item == "s21::SpotLight*") {
-    status = item.value<SpotLight *>()->isActive();
+template <class F>
+F *Illumination::EditField(F Light::*dir, F PointLight::*point,
+                           F SpotLight::*spot) {
+  if (!Contains(current_kind_, current_handle_)) return nullptr;
+  switch (current_kind_) {
+    case Kind::kPoint:
+      return point ? &(point_lights_.Edit(current_handle_).*point) : nullptr;
+    case Kind::kSpot:
+      return spot ? &(spot_lights_.Edit(current_handle_).*spot) : nullptr;
+    default:
+      return dir ? &(dir_lights_.Edit(current_handle_).*dir) : nullptr;
   }
-  return status;
 }
 
-void Illumination::SetItemStatus(QString type, int index, bool status) {
-  QVariant item = illumination_.value(type)->at(index);
-  if (type == "dirLight") {
-    item.value<Light *>()->SetActive(status);
-  } else if (type == "pointLight") {
-    item.value<PointLight *>()->SetActive(status);
-  } else if (type == "spotLight") {
-    item.value<SpotLight *>()->SetActive(status);
+void Illumination::RemoveLight(QString type, int handle) {
+  switch (KindOf(type)) {
+    case Kind::kPoint:
+      point_lights_.Remove(handle);
+      break;
+    case Kind::kSpot:
+      spot_lights_.Remove(handle);
+      break;
+    default:
+      dir_lights_.Remove(handle);
+      break;
   }
 }
 
-bool Illumination::HasItem(QString type, int index) {
-  if (illumination_.value(type)->size() > index) {
-    return true;
-  } else {
-    return false;
+void Illumination::SetItemStatus(QString type, int handle, bool status) {
+  switch (KindOf(type)) {
+    case Kind::kPoint:
+      point_lights_.SetEnabled(handle, status);
+      break;
+    case Kind::kSpot:
+      spot_lights_.SetEnabled(handle, status);
+      break;
+    default:
+      dir_lights_.SetEnabled(handle, status);
+      break;
   }
 }
 
 void Illumination::SetItemDistance(int index) {
-  QVariant item =
-      illumination_.value(current_light_.first)->at(current_light_.second);
-  if (current_light_.first == "pointLight") {
-    item.value<PointLight *>()->SetDistance(index);
-  } else if (current_light_.first == "spotLight") {
-    item.value<SpotLight *>()->SetDistance(index);
+  if (index < 0 || index >= kDistanceCount ||
+      !Contains(current_kind_, current_handle_)) {
+    return;
+  }
+  if (current_kind_ == Kind::kPoint) {
+    SetAttenuation(point_lights_.Edit(current_handle_), index);
+  } else if (current_kind_ == Kind::kSpot) {
+    SetAttenuation(spot_lights_.Edit(current_handle_), index);
   }
 }
 
 void Illumination::GetSpecular() {
-  emit Scpecular(*GetLightInfo().value(".specular").value<QVector3D *>());
+  const QVector3D *specular = Field(&Light::specular, &PointLight::specular,
+                                    &SpotLight::specular);
+  if (specular) emit Scpecular(*specular);
 }
 
 void Illumination::GetDiffuse() {
-  emit Diffuse(*GetLightInfo().value(".diffuse").value<QVector3D *>());
+  const QVector3D *diffuse =
+      Field(&Light::diffuse, &PointLight::diffuse, &SpotLight::diffuse);
+  if (diffuse) emit Diffuse(*diffuse);
 }
 
 void Illumination::GetIntensity() {
-  emit Intensity(*GetLightInfo().value(".ambient").value<QVector3D *>());
+  const QVector3D *ambient =
+      Field(&Light::ambient, &PointLight::ambient, &SpotLight::ambient);
+  if (ambient) emit Intensity(*ambient);
 }
 
 void Illumination::SetSpecular(QVector3D data) {
-  *GetLightInfo().value(".specular").value<QVector3D *>() = data;
+  QVector3D *specular = EditField(&Light::specular, &PointLight::specular,
+                                  &SpotLight::specular);
+  if (specular) *specular = data;
 }
 
 void Illumination::SetDiffuse(QVector3D data) {
-  *GetLightInfo().value(".diffuse").value<QVector3D *>() = data;
+  QVector3D *diffuse =
+      EditField(&Light::diffuse, &PointLight::diffuse, &SpotLight::diffuse);
+  if (diffuse) *diffuse = data;
 }
 
 void Illumination::SetIntensity(QVector3D data) {
-  *GetLightInfo().value(".ambient").value<QVector3D *>() = data;
+  QVector3D *ambient =
+      EditField(&Light::ambient, &PointLight::ambient, &SpotLight::ambient);
+  if (ambient) *ambient = data;
 }
 
 void Illumination::SetCut(double value) {
-  *GetLightInfo().value(".cutOff").value<float *>() = value;
+  float *cut = EditField<float>(nullptr, nullptr, &SpotLight::cut_off);
+  if (cut) *cut = value;
 }
 
 void Illumination::SetOuterCut(double value) {
-  *GetLightInfo().value(".outerCutOff").value<float *>() = value;
+  float *cut = EditField<float>(nullptr, nullptr, &SpotLight::outer_cut_off);
+  if (cut) *cut = value;
 }
 
 LightType Illumination::GetLightType() const { return light_type_; }
 
-void Illumination::SetLightType(LightType type) { light_type_ = type; }
+quint64 Illumination::GetRevision() const {
+  return revision_ + dir_lights_.GetRevision() +
+         point_lights_.GetRevision() + spot_lights_.GetRevision();
+}
+
+void Illumination::SetLightType(LightType type) {
+  light_type_ = type;
+  ++revision_;
+}
 
 int Illumination::GetItemDistance() {
-  QVariant item =
-      illumination_.value(current_light_.first)->at(current_light_.second);
-  int distance = 0;
-  if (current_light_.first == "pointLight") {
-    distance = item.value<PointLight *>()->GetDistance();
-  } else if (current_light_.first == "spotLight") {
-    distance = item.value<SpotLight *>()->GetDistance();
+  if (!Contains(current_kind_, current_handle_)) return 0;
+  if (current_kind_ == Kind::kPoint) {
+    return FindDistance(point_lights_.Get(current_handle_));
+  } else if (current_kind_ == Kind::kSpot) {
+    return FindDistance(spot_lights_.Get(current_handle_));
   }
-  return distance;
+  return 0;
 }
 
-void Illumination::ChangeCurrent(QString type, int index) {
-  if (HasItem(type, index)) {
-    current_light_.first = type;
-    current_light_.second = index;
-    if (type != "dirLight") {
+void Illumination::ChangeCurrent(QString type, int handle) {
+  const Kind kind = KindOf(type);
+  if (Contains(kind, handle)) {
+    current_kind_ = kind;
+    current_handle_ = handle;
+    if (kind != Kind::kDir) {
       emit CurentLightDistance(GetItemDistance());
     }
-    emit CurrentLightInfo(GetLightInfo());
+    EmitCurrentInfo();
   }
 }
 
+void Illumination::EmitCurrentInfo() {
+  const QVector3D *direction =
+      Field<QVector3D>(&Light::direction, nullptr, &SpotLight::direction);
+  const QVector3D *position =
+      Field<QVector3D>(nullptr, &PointLight::position, &SpotLight::position);
+  const float *cut = Field<float>(nullptr, nullptr, &SpotLight::cut_off);
+  const float *outer_cut =
+      Field<float>(nullptr, nullptr, &SpotLight::outer_cut_off);
+  emit CurrentLightInfo(direction ? *direction : QVector3D(),
+                        position ? *position : QVector3D(),
+                        cut ? *cut : 0.0, outer_cut ? *outer_cut : 0.0);
+}
+
 void Illumination::ChangeDirectionX(double value) {
-  GetLightInfo().value(".direction").value<QVector3D *>()->setX(value);
+  QVector3D *direction =
+      EditField<QVector3D>(&Light::direction, nullptr, &SpotLight::direction);
+  if (direction) direction->setX(value);
 }
 
 void Illumination::ChangeDirectionY(double value) {
-  GetLightInfo().value(".direction").value<QVector3D *>()->setY(value);
+  QVector3D *direction =
+      EditField<QVector3D>(&Light::direction, nullptr, &SpotLight::direction);
+  if (direction) direction->setY(value);
 }
 
 void Illumination::ChangeDirectionZ(double value) {
-  GetLightInfo().value(".direction").value<QVector3D *>()->setZ(value);
+  QVector3D *direction =
+      EditField<QVector3D>(&Light::direction, nullptr, &SpotLight::direction);
+  if (direction) direction->setZ(value);
 }
 
 void Illumination::ChangePositionX(double value) {
-  GetLightInfo().value(".position").value<QVector3D *>()->setX(value);
+  QVector3D *position = EditField<QVector3D>(nullptr, &PointLight::position,
+                                             &SpotLight::position);
+  if (position) position->setX(value);
 }
 
 void Illumination::ChangePositionY(double value) {
-  GetLightInfo().value(".position").value<QVector3D *>()->setY(value);
+  QVector3D *position = EditField<QVector3D>(nullptr, &PointLight::position,
+                                             &SpotLight::position);
+  if (position) position->setY(value);
 }
 
 void Illumination::ChangePositionZ(double value) {
-  GetLightInfo().value(".position").value<QVector3D *>()->setZ(value);
+  QVector3D *position = EditField<QVector3D>(nullptr, &PointLight::position,
+                                             &SpotLight::position);
+  if (position) position->setZ(value);
 }
 }  // namespace s21
@@ -1,6 +1,10 @@
 #ifndef ILLUMINATION_H
 #define ILLUMINATION_H
 
+#include <QObject>
+#include <QString>
+
+#include "light_array.h"
 #include "spot_light.h"
 
 namespace s21 {
@@ -9,33 +13,50 @@ enum class LightType { kFlat = 0, kSoft };
 class Illumination : public QObject {
   Q_OBJECT
  public:
+  // Handle of the directional light every scene starts with.
+  static const int kSceneLight = 0;
+
   Illumination();
-  ~Illumination();
-  void addLight(QString);
-  QMap<QString, QVariant> &GetLightInfo();
-  QMap<QString, QVariant> &GetLightInfo(QString, int);
+  // Returns the handle of the new light, or -1 for an unknown type.
+  int addLight(QString);
 
-  bool ItemIsActive(QVariant &);
   void SetItemStatus(QString, int, bool);
-  QMap<QString, QVector<QVariant> *> &GetAllLight() { return illumination_; }
-  bool HasItem(QString, int);
+  const LightArray<Light> &GetDirLights() const { return dir_lights_; }
+  const LightArray<PointLight> &GetPointLights() const {
+    return point_lights_;
+  }
+  const LightArray<SpotLight> &GetSpotLights() const { return spot_lights_; }
 
   int GetItemDistance();
   LightType GetLightType() const;
   void SetLightType(LightType type);
+  // Grows on every change that affects rendering.
+  quint64 GetRevision() const;
 
  private:
-  QVariant *currentItem_;
+  enum class Kind { kDir, kPoint, kSpot };
+
+  static Kind KindOf(const QString &type);
+  bool Contains(Kind kind, int handle) const;
+  // The field of the current light, or nullptr when its kind has none.
+  template <class F>
+  const F *Field(F Light::*dir, F PointLight::*point,
+                 F SpotLight::*spot) const;
+  template <class F>
+  F *EditField(F Light::*dir, F PointLight::*point, F SpotLight::*spot);
+  void EmitCurrentInfo();
+
   LightType light_type_ = LightType::kSoft;
+  quint64 revision_ = 0;
 
-  QVector<QVariant> *dirLights_;
-  QVector<QVariant> *pointLights_;
-  QVector<QVariant> *spotLights_;
-  QMap<QString, QVector<QVariant> *> illumination_;
-  QPair<QString, int> current_light_;
+  LightArray<Light> dir_lights_;
+  LightArray<PointLight> point_lights_;
+  LightArray<SpotLight> spot_lights_;
+  Kind current_kind_ = Kind::kDir;
+  int current_handle_ = kSceneLight;
 
  signals:
-  void CurrentLightInfo(QMap<QString, QVariant>);
+  void CurrentLightInfo(QVector3D, QVector3D, double, double);
   void CurentLightDistance(int);
   void Scpecular(QVector3D);
   void Diffuse(QVector3D);
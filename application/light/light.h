@@ -1,34 +1,26 @@
 #ifndef V3D_LIGHT_H_
 #define V3D_LIGHT_H_
 
-#include <QColor>
-#include <QMap>
-#include <QMetaType>
-#include <QString>
-#include <QVariant>
 #include <QVector3D>
 
 namespace s21 {
-class Light {
- public:
-  Light();
-  const bool &isActive() const { return m_active_; }
-  void SetActive(const bool status) { m_active_ = status; }
 
-  const QString &GetType() const { return m_type_; }
-  QMap<QString, QVariant> &GetInfo() { return lightData; }
+static_assert(sizeof(QVector3D) == 3 * sizeof(float),
+              "lights are copied to std140 blocks as is");
 
- protected:
-  QMap<QString, QVariant> lightData;
-
-  bool m_active_;
-  QString m_type_;
-  QVector3D m_direction_;
-  QVector3D m_ambient_;
-  QVector3D m_diffuse_;
-  QVector3D m_specular_;
+// A directional light, laid out like DirLight in the std140 light block.
+struct Light {
+  QVector3D direction{-0.2f, -1.0f, -0.3f};
+  float padding0 = 0.0f;
+  QVector3D ambient{0.05f, 0.05f, 0.05f};
+  float padding1 = 0.0f;
+  QVector3D diffuse{0.4f, 0.4f, 0.4f};
+  float padding2 = 0.0f;
+  QVector3D specular{0.5f, 0.5f, 0.5f};
+  float padding3 = 0.0f;
 };
+static_assert(sizeof(Light) == 64, "Light does not match DirLight");
 
 }  // namespace s21
-Q_DECLARE_METATYPE(s21::Light);
+
 #endif  // V3D_LIGHT_H_
@@ -0,0 +1,88 @@
+#ifndef LIGHT_ARRAY_H_
+#define LIGHT_ARRAY_H_
+
+#include <QVector>
+#include <utility>
+
+namespace s21 {
+
+// Lights of one kind stored contiguously with the enabled ones first, so the
+// enabled range can be copied to the GPU as is. Lights are addressed by
+// handles that stay valid until the light is removed; adding, removing and
+// switching a light on or off swap at most two slots.
+template <class T>
+class LightArray {
+ public:
+  int Add(const T &light = T()) {
+    int handle = m_slots_.size();
+    if (m_free_.isEmpty()) {
+      m_slots_.push_back(0);
+    } else {
+      handle = m_free_.takeLast();
+    }
+    m_slots_[handle] = m_lights_.size();
+    m_lights_.push_back(light);
+    m_owners_.push_back(handle);
+    Swap(m_lights_.size() - 1, m_enabled_++);
+    ++m_revision_;
+    return handle;
+  }
+
+  void Remove(int handle) {
+    if (!Contains(handle)) return;
+    SetEnabled(handle, false);
+    Swap(m_slots_[handle], m_lights_.size() - 1);
+    m_lights_.removeLast();
+    m_owners_.removeLast();
+    m_slots_[handle] = -1;
+    m_free_.push_back(handle);
+    ++m_revision_;
+  }
+
+  void SetEnabled(int handle, bool enabled) {
+    if (!Contains(handle) || IsEnabled(handle) == enabled) return;
+    if (enabled) {
+      Swap(m_slots_[handle], m_enabled_++);
+    } else {
+      Swap(m_slots_[handle], --m_enabled_);
+    }
+    ++m_revision_;
+  }
+
+  bool Contains(int handle) const {
+    return handle >= 0 && handle < m_slots_.size() && m_slots_[handle] >= 0;
+  }
+  bool IsEnabled(int handle) const { return m_slots_[handle] < m_enabled_; }
+
+  const T &Get(int handle) const { return m_lights_[m_slots_[handle]]; }
+  // Counts as a change, the caller is expected to write to the light.
+  T &Edit(int handle) {
+    ++m_revision_;
+    return m_lights_[m_slots_[handle]];
+  }
+
+  const T *GetEnabled() const { return m_lights_.constData(); }
+  int GetEnabledCount() const { return m_enabled_; }
+  int GetCount() const { return m_lights_.size(); }
+  quint64 GetRevision() const { return m_revision_; }
+
+ private:
+  void Swap(int a, int b) {
+    if (a == b) return;
+    std::swap(m_lights_[a], m_lights_[b]);
+    std::swap(m_owners_[a], m_owners_[b]);
+    m_slots_[m_owners_[a]] = a;
+    m_slots_[m_owners_[b]] = b;
+  }
+
+  QVector<T> m_lights_;
+  QVector<int> m_owners_;
+  QVector<int> m_slots_;
+  QVector<int> m_free_;
+  int m_enabled_ = 0;
+  quint64 m_revision_ = 0;
+};
+
+}  // namespace s21
+
+#endif  // LIGHT_ARRAY_H_
@@ -0,0 +1,93 @@
+#include "light_buffer.h"
+
+#include <algorithm>
+
+namespace s21 {
+
+namespace {
+
+// The count is an int padded to a vec4, the array follows.
+const int kHeaderSize = 16;
+const GLint kMaxBlockSize = 1 << 16;
+
+struct Kind {
+  const char *block;
+  const char *define;
+  int stride;
+};
+
+const Kind kKindInfo[LightBuffer::kKinds] = {
+    {"DirLightBlock", "MAX_DIR_LIGHTS", sizeof(Light)},
+    {"PointLightBlock", "MAX_POINT_LIGHTS", sizeof(PointLight)},
+    {"SpotLightBlock", "MAX_SPOT_LIGHTS", sizeof(SpotLight)},
+};
+
+}  // namespace
+
+void LightBuffer::Create(QOpenGLFunctions_4_1_Core &gl) {
+  GLint block_size = 0;
+  gl.glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &block_size);
+  block_size = std::min(block_size, kMaxBlockSize);
+
+  gl.glGenBuffers(kKinds, m_buffers_);
+  for (int i = 0; i < kKinds; ++i) {
+    m_capacity_[i] = (block_size - kHeaderSize) / kKindInfo[i].stride;
+    gl.glBindBuffer(GL_UNIFORM_BUFFER, m_buffers_[i]);
+    gl.glBufferData(GL_UNIFORM_BUFFER,
+                    kHeaderSize + m_capacity_[i] * kKindInfo[i].stride,
+                    nullptr, GL_DYNAMIC_DRAW);
+    gl.glBindBufferBase(GL_UNIFORM_BUFFER, i, m_buffers_[i]);
+  }
+  gl.glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  std::fill(m_revisions_, m_revisions_ + kKinds, ~quint64(0));
+}
+
+void LightBuffer::Destroy(QOpenGLFunctions_4_1_Core &gl) {
+  if (m_buffers_[0]) {
+    gl.glDeleteBuffers(kKinds, m_buffers_);
+    std::fill(m_buffers_, m_buffers_ + kKinds, 0);
+  }
+}
+
+QByteArray LightBuffer::GetDefines() const {
+  QByteArray defines;
+  for (int i = 0; i < kKinds; ++i) {
+    defines += QByteArray("#define ") + kKindInfo[i].define + ' ' +
+               QByteArray::number(std::max(m_capacity_[i], 1)) + '\n';
+  }
+  return defines;
+}
+
+void LightBuffer::Bind(QOpenGLFunctions_4_1_Core &gl,
+                       QOpenGLShaderProgram &shader) const {
+  for (int i = 0; i < kKinds; ++i) {
+    const GLuint index =
+        gl.glGetUniformBlockIndex(shader.programId(), kKindInfo[i].block);
+    if (index != GL_INVALID_INDEX) {
+      gl.glUniformBlockBinding(shader.programId(), index, i);
+    }
+  }
+}
+
+template <class T>
+void LightBuffer::Upload(QOpenGLFunctions_4_1_Core &gl, int kind,
+                         const LightArray<T> &lights) {
+  if (lights.GetRevision() == m_revisions_[kind]) return;
+  m_revisions_[kind] = lights.GetRevision();
+
+  const int count = std::min(lights.GetEnabledCount(), m_capacity_[kind]);
+  gl.glBindBuffer(GL_UNIFORM_BUFFER, m_buffers_[kind]);
+  gl.glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(count), &count);
+  gl.glBufferSubData(GL_UNIFORM_BUFFER, kHeaderSize, count * sizeof(T),
+                     lights.GetEnabled());
+  gl.glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void LightBuffer::Update(QOpenGLFunctions_4_1_Core &gl,
+                         const Illumination &illumination) {
+  Upload(gl, 0, illumination.GetDirLights());
+  Upload(gl, 1, illumination.GetPointLights());
+  Upload(gl, 2, illumination.GetSpotLights());
+}
+
+}  // namespace s21
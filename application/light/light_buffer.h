@@ -0,0 +1,44 @@
+#ifndef LIGHT_BUFFER_H_
+#define LIGHT_BUFFER_H_
+
+#include <QByteArray>
+#include <QOpenGLFunctions_4_1_Core>
+#include <QOpenGLShaderProgram>
+
+#include "illumination.h"
+
+namespace s21 {
+
+// Enabled lights in std140 layout, one uniform buffer per light kind.
+// Programs read them through fixed binding points, so a buffer is only
+// rewritten after its lights change.
+class LightBuffer {
+ public:
+  static const int kKinds = 3;
+
+  // Sizes the light arrays from the largest uniform block the driver
+  // accepts and allocates the buffers.
+  void Create(QOpenGLFunctions_4_1_Core &gl);
+  void Destroy(QOpenGLFunctions_4_1_Core &gl);
+
+  // Array sizes to put in front of every shader that declares the blocks.
+  QByteArray GetDefines() const;
+  void Bind(QOpenGLFunctions_4_1_Core &gl, QOpenGLShaderProgram &shader) const;
+  // Copies the enabled lights of every kind that changed since the last
+  // call straight from the light arrays.
+  void Update(QOpenGLFunctions_4_1_Core &gl,
+              const Illumination &illumination);
+
+ private:
+  template <class T>
+  void Upload(QOpenGLFunctions_4_1_Core &gl, int kind,
+              const LightArray<T> &lights);
+
+  GLuint m_buffers_[kKinds] = {};
+  int m_capacity_[kKinds] = {};
+  quint64 m_revisions_[kKinds] = {};
+};
+
+}  // namespace s21
+
+#endif  // LIGHT_BUFFER_H_
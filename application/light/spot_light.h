@@ -4,18 +4,22 @@
 #include "point_light.h"
 
 namespace s21 {
-class SpotLight : public PointLight {
- public:
-  SpotLight() : PointLight(), m_inner_cone_{12.5f}, m_outer_cone_{15.0f} {
-    m_type_ = "spotLight";
-    lightData.insert(".cutOff", QVariant::fromValue(&m_inner_cone_));
-    lightData.insert(".outerCutOff", QVariant::fromValue(&m_outer_cone_));
-  }
 
- private:
-  float m_inner_cone_;
-  float m_outer_cone_;
+// Laid out like SpotLight in the std140 light block.
+struct SpotLight {
+  QVector3D position{0.7f, 0.2f, 2.0f};
+  float constant = 1.0f;
+  QVector3D direction{-0.2f, -1.0f, -0.3f};
+  float linear = 0.0014f;
+  QVector3D ambient{0.05f, 0.05f, 0.05f};
+  float quadratic = 0.000007f;
+  QVector3D diffuse{0.4f, 0.4f, 0.4f};
+  float cut_off = 12.5f;
+  QVector3D specular{0.5f, 0.5f, 0.5f};
+  float outer_cut_off = 15.0f;
 };
+static_assert(sizeof(SpotLight) == 80, "SpotLight does not match");
+
 }  // namespace s21
-Q_DECLARE_METATYPE(s21::SpotLight);
+
 #endif  // SPOT_LIGHT_H
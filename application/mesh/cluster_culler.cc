@@ -0,0 +1,167 @@
+#include "cluster_culler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace s21 {
+
+namespace {
+
+const int kLanes = 4;
+const int kPlanes = 6;
+
+struct Frustum {
+  float x[kPlanes], y[kPlanes], z[kPlanes], w[kPlanes];
+};
+
+// Gribb-Hartmann planes of the clip matrix, normalized so that plane
+// distances are in model units.
+Frustum ExtractFrustum(const QMatrix4x4 &clip) {
+  Frustum frustum;
+  const QVector4D last = clip.row(3);
+  for (int i = 0; i < 3; ++i) {
+    const QVector4D row = clip.row(i);
+    const QVector4D planes[2] = {last + row, last - row};
+    for (int j = 0; j < 2; ++j) {
+      const float length = planes[j].toVector3D().length();
+      const QVector4D plane = length > 0.0f ? planes[j] / length : planes[j];
+      frustum.x[2 * i + j] = plane.x();
+      frustum.y[2 * i + j] = plane.y();
+      frustum.z[2 * i + j] = plane.z();
+      frustum.w[2 * i + j] = plane.w();
+    }
+  }
+  return frustum;
+}
+
+}  // namespace
+
+ClusterCuller::ClusterCuller(const QVector<MeshCluster> &clusters) {
+  const size_t size = clusters.size() + kLanes - 1;
+  m_x_.resize(size);
+  m_y_.resize(size);
+  m_z_.resize(size);
+  m_radius_.resize(size);
+  m_axis_x_.resize(size);
+  m_axis_y_.resize(size);
+  m_axis_z_.resize(size);
+  m_cutoff_.resize(size, 2.0f);
+  m_ranges_.reserve(clusters.size());
+  for (int i = 0; i < clusters.size(); ++i) {
+    const MeshCluster &cluster = clusters[i];
+    m_x_[i] = cluster.center.x();
+    m_y_[i] = cluster.center.y();
+    m_z_[i] = cluster.center.z();
+    m_radius_[i] = cluster.radius;
+    m_axis_x_[i] = cluster.cone_axis.x();
+    m_axis_y_[i] = cluster.cone_axis.y();
+    m_axis_z_[i] = cluster.cone_axis.z();
+    m_cutoff_[i] = cluster.cone_cutoff;
+    m_ranges_.push_back({cluster.first, cluster.count});
+  }
+}
+
+void ClusterCuller::Cull(int first, int count, const QMatrix4x4 &model_view,
+                         const QMatrix4x4 &projection, bool cones,
+                         QVector<IndexRange> &ranges,
+                         ClusterStats &stats) const {
+  const Frustum frustum = ExtractFrustum(projection * model_view);
+
+  // The cone test looks from the eye to the cluster centre. An orthographic
+  // camera has no eye, so every cluster is seen along the view direction:
+  // the centre is scaled out and the radius term dropped.
+  const QMatrix4x4 inverse = model_view.inverted();
+  const bool orthographic = projection(3, 3) != 0.0f;
+  const float scale = orthographic ? 0.0f : 1.0f;
+  const QVector3D eye =
+      orthographic ? -inverse.mapVector(QVector3D(0.0f, 0.0f, -1.0f))
+                         .normalized()
+                   : inverse.map(QVector3D(0.0f, 0.0f, 0.0f));
+
+  stats.clusters += count;
+  for (int i = first; i < first + count; i += kLanes) {
+    const int lanes = std::min(kLanes, first + count - i);
+    int outside = 0, backface = 0;
+#ifdef __SSE2__
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 x = _mm_loadu_ps(&m_x_[i]);
+    const __m128 y = _mm_loadu_ps(&m_y_[i]);
+    const __m128 z = _mm_loadu_ps(&m_z_[i]);
+    const __m128 radius = _mm_loadu_ps(&m_radius_[i]);
+    __m128 culled = zero;
+    for (int p = 0; p < kPlanes; ++p) {
+      __m128 distance = _mm_add_ps(
+          _mm_mul_ps(x, _mm_set1_ps(frustum.x[p])),
+          _mm_mul_ps(y, _mm_set1_ps(frustum.y[p])));
+      distance = _mm_add_ps(distance,
+                            _mm_mul_ps(z, _mm_set1_ps(frustum.z[p])));
+      distance = _mm_add_ps(distance, _mm_set1_ps(frustum.w[p]));
+      culled = _mm_or_ps(culled,
+                         _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+    }
+    outside = _mm_movemask_ps(culled);
+
+    if (cones) {
+      const __m128 k = _mm_set1_ps(scale);
+      const __m128 dx = _mm_sub_ps(_mm_mul_ps(x, k), _mm_set1_ps(eye.x()));
+      const __m128 dy = _mm_sub_ps(_mm_mul_ps(y, k), _mm_set1_ps(eye.y()));
+      const __m128 dz = _mm_sub_ps(_mm_mul_ps(z, k), _mm_set1_ps(eye.z()));
+      __m128 dot = _mm_add_ps(
+          _mm_mul_ps(dx, _mm_loadu_ps(&m_axis_x_[i])),
+          _mm_mul_ps(dy, _mm_loadu_ps(&m_axis_y_[i])));
+      dot = _mm_add_ps(dot, _mm_mul_ps(dz, _mm_loadu_ps(&m_axis_z_[i])));
+      __m128 length = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+      length = _mm_sqrt_ps(_mm_add_ps(length, _mm_mul_ps(dz, dz)));
+      const __m128 limit =
+          _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&m_cutoff_[i]), length),
+                     _mm_mul_ps(radius, k));
+      backface = _mm_movemask_ps(_mm_cmpge_ps(dot, limit));
+    }
+#else
+    for (int j = 0; j < lanes; ++j) {
+      const int c = i + j;
+      for (int p = 0; p < kPlanes; ++p) {
+        const float distance = m_x_[c] * frustum.x[p] +
+                               m_y_[c] * frustum.y[p] +
+                               m_z_[c] * frustum.z[p] + frustum.w[p];
+        if (distance + m_radius_[c] < 0.0f) outside |= 1 << j;
+      }
+
+      if (cones) {
+        const float dx = m_x_[c] * scale - eye.x();
+        const float dy = m_y_[c] * scale - eye.y();
+        const float dz = m_z_[c] * scale - eye.z();
+        const float dot =
+            dx * m_axis_x_[c] + dy * m_axis_y_[c] + dz * m_axis_z_[c];
+        const float length = std::sqrt(dx * dx + dy * dy + dz * dz);
+        if (dot >= m_cutoff_[c] * length + m_radius_[c] * scale) {
+          backface |= 1 << j;
+        }
+      }
+    }
+#endif
+
+    for (int j = 0; j < lanes; ++j) {
+      if (outside >> j & 1) {
+        ++stats.frustum_culled;
+      } else if (backface >> j & 1) {
+        ++stats.cone_culled;
+      } else {
+        const IndexRange &range = m_ranges_[i + j];
+        stats.triangles += range.count / 3;
+        if (!ranges.isEmpty() &&
+            ranges.last().first + ranges.last().count == range.first) {
+          ranges.last().count += range.count;
+        } else {
+          ranges.push_back(range);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace s21
@@ -0,0 +1,52 @@
+#ifndef CLUSTER_CULLER_H_
+#define CLUSTER_CULLER_H_
+
+#include <QMatrix4x4>
+#include <QVector3D>
+#include <QVector>
+#include <vector>
+
+#include "mesh_information.h"
+
+namespace s21 {
+
+// A compact group of at most MeshClusters::kMaxTriangles triangles. All
+// normals lie within the cone around cone_axis; cone_cutoff is the sine of
+// its half angle, or above 1 when the cluster can never be backface culled.
+struct MeshCluster {
+  int first = 0;
+  int count = 0;
+  QVector3D center;
+  float radius = 0.0f;
+  QVector3D cone_axis;
+  float cone_cutoff = 2.0f;
+};
+
+struct IndexRange {
+  int first;
+  int count;
+};
+
+// Keeps the cluster bounds as structure of arrays so that four clusters are
+// tested against the frustum and their normal cones at once.
+class ClusterCuller {
+ public:
+  ClusterCuller() = default;
+  explicit ClusterCuller(const QVector<MeshCluster> &clusters);
+
+  // Appends the index ranges of the visible clusters in [first, first +
+  // count), merging neighbours. Cone culling is only valid for opaque
+  // filled surfaces, so the caller decides whether to use it.
+  void Cull(int first, int count, const QMatrix4x4 &model_view,
+            const QMatrix4x4 &projection, bool cones,
+            QVector<IndexRange> &ranges, ClusterStats &stats) const;
+
+ private:
+  std::vector<float> m_x_, m_y_, m_z_, m_radius_;
+  std::vector<float> m_axis_x_, m_axis_y_, m_axis_z_, m_cutoff_;
+  std::vector<IndexRange> m_ranges_;
+};
+
+}  // namespace s21
+
+#endif  // CLUSTER_CULLER_H_
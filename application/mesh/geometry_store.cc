@@ -0,0 +1,154 @@
+#include "geometry_store.h"
+
+#include <QByteArray>
+#include <QMultiHash>
+#include <QVector>
+#include <cstring>
+
+#include "content_hash.h"
+#include "mesh_data.h"
+
+namespace s21 {
+
+namespace {
+
+struct Geometry {
+  quint64 hash = 0;
+  ArenaBuffer layout = ArenaBuffer::kVertices;
+  qint64 vertex_bytes = 0;
+  qint64 index_bytes = 0;
+  int vertex_range = -1;
+  int index_range = -1;
+  int references = 0;
+  qint64 bytes = 0;
+  qint64 triangles = 0;
+};
+
+struct State {
+  QVector<Geometry> geometries;
+  QVector<int> free_handles;
+  QMultiHash<quint64, int> handles;
+};
+
+State &GetState() {
+  static State state;
+  return state;
+}
+
+bool IsValid(const State &state, int handle) {
+  return handle >= 0 && handle < state.geometries.size() &&
+         state.geometries[handle].references > 0;
+}
+
+template <typename T>
+quint64 HashVector(const QVector<T> &values, quint64 seed) {
+  return HashBytes(reinterpret_cast<const char *>(values.constData()),
+                   values.size() * sizeof(T), seed);
+}
+
+// Compares the bytes against what the range holds on the GPU.
+bool IsStored(int range, const void *data, qint64 bytes) {
+  QByteArray stored(bytes, Qt::Uninitialized);
+  return BufferArena::Read(range, stored.data(), bytes) &&
+         !std::memcmp(stored.constData(), data, bytes);
+}
+
+}  // namespace
+
+quint64 GeometryStore::Hash(const MeshData &data) {
+  // Meshes are hashed in parallel by the importer, so each one is hashed
+  // in a single pass. The layout and index type seed the hashes, equal
+  // bytes in another format are different geometry.
+  quint64 hash = data.compact_vertices.isEmpty()
+                     ? HashVector(data.vertices, sizeof(Vertex))
+                     : HashVector(data.compact_vertices, sizeof(CompactVertex));
+  hash = data.short_indices.isEmpty()
+             ? HashVector(data.indices, hash ^ sizeof(unsigned int))
+             : HashVector(data.short_indices, hash ^ sizeof(quint16));
+  return hash;
+}
+
+int GeometryStore::Acquire(quint64 hash, ArenaBuffer layout,
+                           const void *vertices, qint64 vertex_bytes,
+                           const void *indices, qint64 index_bytes) {
+  State &state = GetState();
+  // The CPU copy of stored geometry is gone, so a hit is read back from the
+  // arena. It happens once per shared mesh, at load time.
+  for (int handle : state.handles.values(hash)) {
+    Geometry &geometry = state.geometries[handle];
+    if (geometry.layout != layout || geometry.vertex_bytes != vertex_bytes ||
+        geometry.index_bytes != index_bytes ||
+        !IsStored(geometry.vertex_range, vertices, vertex_bytes) ||
+        !IsStored(geometry.index_range, indices, index_bytes)) {
+      continue;
+    }
+    ++geometry.references;
+    return handle;
+  }
+  return -1;
+}
+
+int GeometryStore::Insert(quint64 hash, ArenaBuffer layout,
+                          const void *vertices, qint64 vertex_bytes,
+                          const void *indices, qint64 index_bytes,
+                          qint64 triangles) {
+  State &state = GetState();
+  Geometry geometry;
+  geometry.hash = hash;
+  geometry.layout = layout;
+  geometry.vertex_bytes = vertex_bytes;
+  geometry.index_bytes = index_bytes;
+  geometry.vertex_range = BufferArena::Add(layout, vertices, vertex_bytes);
+  geometry.index_range =
+      BufferArena::Add(ArenaBuffer::kIndices, indices, index_bytes);
+  geometry.references = 1;
+  geometry.bytes = vertex_bytes + index_bytes;
+  geometry.triangles = triangles;
+
+  int handle = state.geometries.size();
+  if (state.free_handles.isEmpty()) {
+    state.geometries.push_back(geometry);
+  } else {
+    handle = state.free_handles.takeLast();
+    state.geometries[handle] = geometry;
+  }
+  state.handles.insert(hash, handle);
+  return handle;
+}
+
+void GeometryStore::Release(int handle) {
+  State &state = GetState();
+  if (!IsValid(state, handle)) return;
+  Geometry &geometry = state.geometries[handle];
+  if (--geometry.references > 0) return;
+  BufferArena::Remove(geometry.vertex_range);
+  BufferArena::Remove(geometry.index_range);
+  state.handles.remove(geometry.hash, handle);
+  geometry = Geometry();
+  state.free_handles.push_back(handle);
+}
+
+int GeometryStore::GetVertexRange(int handle) {
+  const State &state = GetState();
+  return IsValid(state, handle) ? state.geometries[handle].vertex_range : -1;
+}
+
+int GeometryStore::GetIndexRange(int handle) {
+  const State &state = GetState();
+  return IsValid(state, handle) ? state.geometries[handle].index_range : -1;
+}
+
+GeometryStats GeometryStore::GetStats() {
+  GeometryStats stats;
+  for (const Geometry &it : GetState().geometries) {
+    if (!it.references) continue;
+    ++stats.geometries;
+    stats.references += it.references;
+    stats.triangles += it.triangles;
+    stats.bytes += it.bytes;
+    stats.saved_bytes += (it.references - 1) * it.bytes;
+  }
+  return stats;
+}
+
+}  // namespace s21
@@ -0,0 +1,53 @@
+#ifndef GEOMETRY_STORE_H_
+#define GEOMETRY_STORE_H_
+
+#include <QtGlobal>
+
+#include "buffer_arena.h"
+
+namespace s21 {
+
+struct MeshData;
+
+struct GeometryStats {
+  int geometries = 0;
+  int references = 0;
+  qint64 triangles = 0;
+  qint64 bytes = 0;
+  // Bytes the extra references would have uploaded on their own.
+  qint64 saved_bytes = 0;
+};
+
+// Process-wide mesh geometry addressed by the hash of its content. Meshes
+// whose vertices and indices are equal, in one file or across files, share
+// a single vertex and index range of the BufferArena, released with the
+// last reference. A hash hit is only shared once the stored bytes match,
+// colliding geometry is kept next to it under the same hash. Must be used
+// from the GL thread, the hash aside.
+class GeometryStore {
+ public:
+  // Hash of what a mesh uploads: its vertex layout, vertices and indices.
+  // Safe to call from any thread.
+  static quint64 Hash(const MeshData &data);
+
+  // Takes a reference to the geometry stored under hash with the same
+  // layout and bytes, or returns -1.
+  static int Acquire(quint64 hash, ArenaBuffer layout, const void *vertices,
+                     qint64 vertex_bytes, const void *indices,
+                     qint64 index_bytes);
+  // Uploads the geometry and stores it under hash with one reference.
+  static int Insert(quint64 hash, ArenaBuffer layout, const void *vertices,
+                    qint64 vertex_bytes, const void *indices,
+                    qint64 index_bytes, qint64 triangles);
+  static void Release(int handle);
+
+  // BufferArena handles of the geometry.
+  static int GetVertexRange(int handle);
+  static int GetIndexRange(int handle);
+
+  static GeometryStats GetStats();
+};
+
+}  // namespace s21
+
+#endif  // GEOMETRY_STORE_H_
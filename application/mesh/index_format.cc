@@ -0,0 +1,107 @@
+#include "index_format.h"
+
+#include <vector>
+
+#include "global_settings.h"
+#include "parallel.h"
+
+namespace s21 {
+
+namespace {
+
+MeshData CreatePart(const MeshData &mesh, int number) {
+  MeshData part;
+  part.name = mesh.name + "." + QString::number(number);
+  part.textures = mesh.textures;
+  part.material = mesh.material;
+  return part;
+}
+
+QVector<MeshData> SplitMesh(MeshData &mesh) {
+  QVector<MeshData> parts;
+  std::vector<int> remap(mesh.vertices.size(), -1);
+  std::vector<unsigned int> used;
+
+  MeshData part = CreatePart(mesh, 0);
+  auto flush = [&]() {
+    for (auto it : used) remap[it] = -1;
+    used.clear();
+    parts.push_back(std::move(part));
+    part = CreatePart(mesh, parts.size());
+  };
+
+  for (int i = 0; i + 2 < mesh.indices.size(); i += 3) {
+    int fresh = 0;
+    for (int j = 0; j < 3; ++j) {
+      fresh += remap[mesh.indices[i + j]] < 0;
+    }
+    if (part.vertices.size() + fresh > IndexFormat::kShortLimit) {
+      flush();
+    }
+    for (int j = 0; j < 3; ++j) {
+      const unsigned int index = mesh.indices[i + j];
+      if (remap[index] < 0) {
+        remap[index] = part.vertices.size();
+        used.push_back(index);
+        const Vertex &vertex = mesh.vertices[index];
+        part.vertices.push_back(vertex);
+        for (int k = 0; k < 3; ++k) {
+          part.min_value[k] = std::min(part.min_value[k], vertex.Position[k]);
+          part.max_value[k] = std::max(part.max_value[k], vertex.Position[k]);
+        }
+      }
+      part.indices.push_back(remap[index]);
+    }
+  }
+  if (!part.indices.isEmpty()) {
+    parts.push_back(std::move(part));
+  }
+  return parts;
+}
+
+}  // namespace
+
+bool IndexFormat::IsSplit() {
+  return GlobalSetting::haveSettings("splitMeshes") &&
+         GlobalSetting::getSettings("splitMeshes").toBool();
+}
+
+void IndexFormat::SetSplit(bool split) {
+  GlobalSetting::setSettings("splitMeshes", split);
+}
+
+void IndexFormat::Split(QVector<MeshData> &meshes) {
+  std::vector<QVector<MeshData>> parts(meshes.size());
+  ParallelFor(meshes.size(), [&](size_t i) {
+    if (meshes[i].vertices.size() > kShortLimit &&
+        meshes[i].indices.size() % 3 == 0) {
+      parts[i] = SplitMesh(meshes[i]);
+    }
+  });
+
+  QVector<MeshData> result;
+  for (int i = 0; i < meshes.size(); ++i) {
+    if (parts[i].isEmpty()) {
+      result.push_back(std::move(meshes[i]));
+    } else {
+      for (auto &it : parts[i]) {
+        result.push_back(std::move(it));
+      }
+    }
+  }
+  meshes = std::move(result);
+}
+
+void IndexFormat::Pack(MeshData &mesh) {
+  const int vertex_count =
+      std::max(mesh.vertices.size(), mesh.compact_vertices.size());
+  if (vertex_count > kShortLimit) {
+    return;
+  }
+  mesh.short_indices.resize(mesh.indices.size());
+  std::copy(mesh.indices.begin(), mesh.indices.end(),
+            mesh.short_indices.begin());
+  mesh.indices = QVector<unsigned int>();
+}
+
+}  // namespace s21
@@ -0,0 +1,26 @@
+#ifndef INDEX_FORMAT_H_
+#define INDEX_FORMAT_H_
+
+#include <QVector>
+
+#include "mesh_data.h"
+
+namespace s21 {
+
+class IndexFormat {
+ public:
+  static const int kShortLimit = 1 << 16;
+
+  static bool IsSplit();
+  static void SetSplit(bool split);
+
+  // Splits meshes with more than kShortLimit vertices into parts that fit
+  // 16-bit indices. Material, textures and names are kept.
+  static void Split(QVector<MeshData> &meshes);
+  // Moves the indices into short_indices when every vertex is addressable.
+  static void Pack(MeshData &mesh);
+};
+
+}  // namespace s21
+
+#endif  // INDEX_FORMAT_H_
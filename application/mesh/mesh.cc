@@ -1,229 +1,437 @@
 #include "mesh.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "geometry_store.h"
+#include "mesh_data.h"
+#include "texture_cache.h"
+#include "texture_loader.h"
+
 namespace s21 {
 
-Mesh::Mesh(const char *name, QVector<Vertex> &&vertices,
-           QVector<unsigned int> &&indices, QVector<Texture *> &&textures,
-           Material &&material)
-    : VBO(QOpenGLBuffer::VertexBuffer),
-      EBO(QOpenGLBuffer::IndexBuffer),
-      vertices(vertices),
-      indices(indices),
-      textures(textures),
-      material(material),
-      save_material(material) {
+MaterialBlock::MaterialBlock(const Material &material)
+    : Ka(material.Ka),
+      Ns(material.Ns),
+      Kd(material.Kd),
+      Ni(material.Ni),
+      Ks(material.Ks),
+      d(material.d),
+      Ke(material.Ke),
+      roughness(material.roughness),
+      reflection(material.reflection),
+      refraction(material.refraction) {}
+
+InstanceData::InstanceData() : InstanceData(QMatrix4x4(), QVector4D()) {}
+
+InstanceData::InstanceData(const QMatrix4x4 &matrix, const QVector4D &tint)
+    : color{tint.x(), tint.y(), tint.z(), tint.w()} {
+  std::copy(matrix.constData(), matrix.constData() + 16, transform);
+}
+
+Mesh::Mesh(MeshData &&data, QVector<TextureBinding> &&textures)
+    : hash(data.hash),
+      material_buffer(QOpenGLBuffer::VertexBuffer),
+      vertices(std::move(data.vertices)),
+      compact_vertices(std::move(data.compact_vertices)),
+      indices(std::move(data.indices)),
+      short_indices(std::move(data.short_indices)),
+      index_count(indices.size() + short_indices.size()),
+      index_type(short_indices.isEmpty() ? GL_UNSIGNED_INT
+                                         : GL_UNSIGNED_SHORT),
+      lods(std::move(data.lods)),
+      culler(data.clusters),
+      compact(!compact_vertices.isEmpty()),
+      position_offset(0.0f, 0.0f, 0.0f),
+      position_scale(1.0f, 1.0f, 1.0f),
+      center((data.min_value + data.max_value) / 2.0f),
+      radius((data.max_value - data.min_value).length() / 2.0f) {
+  if (lods.isEmpty()) {
+    lods.push_back({0, index_count, 0.0f});
+  }
+  ranges.push_back({lods[0].first, lods[0].count});
+  if (data.parts.isEmpty()) {
+    data.parts.push_back({data.name, lods[0].first, lods[0].count,
+                          int(vertices.size() + compact_vertices.size())});
+  }
+  parts.resize(data.parts.size());
+  for (int i = 0; i < parts.size(); ++i) {
+    MeshPart &part = parts[i];
+    part.first = data.parts[i].first;
+    part.count = data.parts[i].count;
+    part.textures = textures;
+    part.material = data.material;
+    part.save_material = data.material;
+    part.info.name = data.parts[i].name;
+    part.info.vertices_count = data.parts[i].vertex_count;
+    part.info.face_count = part.count / 3;
+    part.info.lod_count = lods.size();
+  }
+  if (compact) {
+    position_offset = data.min_value;
+    position_scale = (data.max_value - data.min_value) / 65535.0f;
+  }
   SetupMesh();
-  info.vertices_count = vertices.count();
-  info.face_count = indices.count() / 3;
-  info.name = name;
+  info.vertices_count = vertices.count() + compact_vertices.count();
+  info.face_count = lods[0].count / 3;
+  info.vertex_bytes = vertices.count() * sizeof(Vertex) +
+                      compact_vertices.count() * sizeof(CompactVertex);
+  const qint64 index_size =
+      index_type == GL_UNSIGNED_SHORT ? sizeof(quint16) : sizeof(unsigned int);
+  info.index_bytes = lods[0].count * index_size;
+  info.lod_bytes = (index_count - lods[0].count) * index_size;
+  info.lod_count = lods.size();
+  info.name = data.name;
+  info.hash = hash;
+  ReleaseData();
 }
 
 Mesh::~Mesh() {
-  VBO.destroy();
-  EBO.destroy();
-  VAO.destroy();
+  GeometryStore::Release(geometry);
+  material_buffer.destroy();
 }
 
 MeshInfo Mesh::GetInfo() const { return info; }
 
-Material &Mesh::GetMaterial() { return material; }
+QVector<MeshPart> &Mesh::GetParts() { return parts; }
+
+QVector3D Mesh::GetCenter() const { return center; }
+
+ArenaBuffer Mesh::GetLayout() const { return layout; }
+
+GLenum Mesh::GetIndexType() const { return index_type; }
+
+QVector3D Mesh::GetPositionOffset() const { return position_offset; }
+
+QVector3D Mesh::GetPositionScale() const { return position_scale; }
+
+QVector<int> Mesh::GetRuns() const {
+  QVector<int> runs{0};
+  for (int i = 1; i < parts.size(); ++i) {
+    if (!parts[i].HasSameState(parts[runs.back()])) {
+      runs.push_back(i);
+    }
+  }
+  runs.push_back(parts.size());
+  return runs;
+}
+
+MeshInfo MeshPart::GetInfo() const { return info; }
+
+Material &MeshPart::GetMaterial() { return material; }
+
+const QVector<TextureBinding> &MeshPart::GetTextures() const {
+  return textures;
+}
+
+bool MeshPart::HasSameState(const MeshPart &other) const {
+  if (!(material == other.material) ||
+      textures.size() != other.textures.size()) {
+    return false;
+  }
+  for (int i = 0; i < textures.size(); ++i) {
+    if (textures[i].type != other.textures[i].type ||
+        textures[i].texture != other.textures[i].texture) {
+      return false;
+    }
+  }
+  return true;
+}
 
-void Mesh::ChangeTexture(QImage img, const QString &path) {
-  QImage data(1, 1, QImage::Format_RGB32);
-  data.fill(Qt::black);
+void MeshPart::ChangeTexture(QImage img, const QString &path) {
+  QSharedPointer<Texture> texture =
+      TextureCache::Insert(path, TextureSampler(),
+                           TextureLoader::BuildMipChain(img));
   for (auto &it : textures) {
-    it->texture.destroy();
-    it->texture.create();
-    if (it->type == "texture_ambient") {
-      it->texture.setData(img);
-      it->path = path;
-    } else if (it->type == "texture_diffuse") {
-      it->texture.setData(img);
-      it->path = path;
+    if (texture &&
+        (it.type == "texture_ambient" || it.type == "texture_diffuse")) {
+      it.texture = texture;
     } else {
-      it->texture.setData(data);
-      it->path = "";
+      it.texture = TextureCache::GetDefault(Qt::black);
     }
   }
 }
 
-void Mesh::DelTexture() {
-  QImage data(1, 1, QImage::Format_RGB32);
-  data.fill(Qt::black);
+void MeshPart::DelTexture() {
   for (auto &it : textures) {
-    it->texture.destroy();
-    it->texture.create();
-    it->texture.setData(data);
-    it->path = "";
-  }
-}
-
-void Mesh::SetDefaultMaterial() { material = save_material; }
-
-void Mesh::DrawTexture(const ModelSettings &settings,
-                       QOpenGLShaderProgram &shader) {
-  SetAttribute(shader);
-
-  if (settings.GetTextureSettings().type != TextureType::kNo) {
-    for (unsigned int i = 0; i < textures.size(); i++) {
-      QString name = textures[i]->type;
-      if (name == "texture_ambient") {
-        shader.setUniformValue("material.ambient", i);
-      } else if (name == "texture_diffuse") {
-        shader.setUniformValue("material.diffuse", i);
-      } else if (name == "texture_specular") {
-        shader.setUniformValue("material.specular", i);
-      } else if (name == "texture_normal") {
-        shader.setUniformValue("material.normal", i);
-      } else if (name == "texture_height") {
-        shader.setUniformValue("material.height", i);
-      }
-      textures[i]->texture.bind(i);
-    }
+    it.texture = TextureCache::GetDefault(Qt::black);
+  }
+}
 
-    if (settings.GetTextureSettings().type == TextureType::kSurface) {
-      glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    } else if (settings.GetTextureSettings().type == TextureType::kWireFrame) {
-      glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+void MeshPart::MirrorTexture() {
+  TextureSampler sampler;
+  sampler.mirrored = true;
+  for (auto &it : textures) {
+    if (!it.texture->path.isEmpty()) {
+      QSharedPointer<Texture> texture =
+          TextureCache::Load(it.texture->path, sampler);
+      if (texture) {
+        it.texture = texture;
+      }
     }
+  }
+}
 
-    shader.setUniformValue("material.Ns", material.Ns);
-    shader.setUniformValue("material.Ni", material.Ni);
-    shader.setUniformValue("material.d", material.d);
-    shader.setUniformValue("material.roughness", material.roughness);
-    shader.setUniformValue("material.reflection", material.reflection);
-    shader.setUniformValue("material.refraction", material.refraction);
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr);
+void MeshPart::SetDefaultMaterial() { material = save_material; }
+
+int Mesh::SelectLod(const QMatrix4x4 &model_view,
+                    const QMatrix4x4 &projection, float height,
+                    float threshold) {
+  const QVector3D view_center = model_view.map(center);
+  const float scale = std::max(
+      {model_view.column(0).toVector3D().length(),
+       model_view.column(1).toVector3D().length(),
+       model_view.column(2).toVector3D().length()});
+  const QVector4D clip = projection * QVector4D(view_center, 1.0f);
+  const float depth = clip.w() - std::fabs(projection(3, 2)) * radius * scale;
+  const float pixels = projection(1, 1) * height / 2.0f * scale;
+
+  uniform = true;
+  for (int i = 1; i < parts.size() && uniform; ++i) {
+    uniform = parts[i].HasSameState(parts.front());
+  }
 
-    for (unsigned int i = 0; i < textures.size(); i++) {
-      textures[i]->texture.release(i);
+  lod = 0;
+  if (uniform && depth > 0.0f) {
+    while (lod + 1 < lods.size() &&
+           lods[lod + 1].error * pixels <= threshold * depth) {
+      ++lod;
     }
-
-    DisibleAttribute(shader);
   }
+  ranges.clear();
+  ranges.push_back({lods[lod].first, lods[lod].count});
+  return lods[lod].count / 3;
 }
 
-void Mesh::DrawMaterial(const ModelSettings &settings,
-                        QOpenGLShaderProgram &shader) {
-  SetAttribute(shader);
+void Mesh::CullClusters(const QMatrix4x4 &model_view,
+                        const QMatrix4x4 &projection, bool cones,
+                        ClusterStats &stats) {
+  const MeshLod &level = lods[lod];
+  if (!level.cluster_count) {
+    stats.triangles += level.count / 3;
+    return;
+  }
+  for (const MeshPart &it : parts) {
+    cones = cones && it.material.d >= 1.0f;
+  }
+  // From inside a closed mesh only the back faces are seen, and the cone
+  // test would drop all of them.
+  const QVector3D eye = model_view.inverted().map(QVector3D(0.0f, 0.0f, 0.0f));
+  cones = cones && (eye - center).length() > radius;
+  ranges.clear();
+  culler.Cull(level.first_cluster, level.cluster_count, model_view,
+              projection, cones, ranges, stats);
+}
 
-  if (settings.GetTextureSettings().type != TextureType::kNo) {
-    if (settings.GetTextureSettings().type == TextureType::kSurface) {
-      glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    } else if (settings.GetTextureSettings().type == TextureType::kWireFrame) {
-      glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+void Mesh::UpdateMaterials() {
+  material_buffer.bind();
+  for (int i = 0; i < parts.size(); ++i) {
+    const MaterialBlock block(parts[i].material);
+    if (std::memcmp(&block, &material_blocks[i], sizeof(block))) {
+      material_blocks[i] = block;
+      material_buffer.write(parts[i].material_offset, &block, sizeof(block));
     }
+  }
+  material_buffer.release();
+}
 
-    shader.setUniformValue("material.Ns", material.Ns);
-    shader.setUniformValue("material.Ka", material.Ka);
-    shader.setUniformValue("material.Kd", material.Kd);
-    shader.setUniformValue("material.Ks", material.Ks);
-    shader.setUniformValue("material.Ke", material.Ke);
-    shader.setUniformValue("material.Ni", material.Ni);
-    shader.setUniformValue("material.roughness", material.roughness);
-    shader.setUniformValue("material.d", material.d);
-    shader.setUniformValue("material.reflection", material.reflection);
-    shader.setUniformValue("material.refraction", material.refraction);
-
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr);
+void Mesh::DrawTexture(const ModelSettings &settings, ShaderProgram &shader,
+                       GlState &state, int begin, int end,
+                       GLsizei instances) {
+  BindSurface(settings, shader, state);
+  BindTextures(parts[begin], shader, state);
+  BindMaterial(parts[begin], state);
+  DrawRun(state, begin, end, instances);
+}
 
-    DisibleAttribute(shader);
-  }
+void Mesh::DrawMaterial(const ModelSettings &settings, ShaderProgram &shader,
+                        GlState &state, int begin, int end,
+                        GLsizei instances) {
+  BindSurface(settings, shader, state);
+  BindMaterial(parts[begin], state);
+  DrawRun(state, begin, end, instances);
 }
 
-void Mesh::DrawEdge(const ModelSettings &settings,
-                    QOpenGLShaderProgram &shader) {
+void Mesh::DrawEdge(const ModelSettings &settings, ShaderProgram &shader,
+                    GlState &state, GLsizei instances) {
   if (settings.GetEdgeSettings().type != EdgeType::kNo) {
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-
-    SetAttribute(shader);
+    state.PolygonMode(GL_FILL);
 
-    shader.setUniformValue("u_thickness", settings.GetEdgeSettings().size);
-    shader.setUniformValue("PointColor", settings.GetEdgeSettings().color);
+    BindMesh(shader, state);
 
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr);
+    shader.SetUniform(Uniform::kThickness, settings.GetEdgeSettings().size);
+    shader.SetUniform(Uniform::kPointColor, settings.GetEdgeSettings().color);
 
-    DisibleAttribute(shader);
+    DrawElements(state, instances);
   }
 }
 
-void Mesh::DrawVertex(const ModelSettings &settings,
-                      QOpenGLShaderProgram &shader) {
+void Mesh::DrawVertex(const ModelSettings &settings, ShaderProgram &shader,
+                      GlState &state, GLsizei instances) {
   if (settings.GetVertexSettings().type != VertexType::kNo) {
-    glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
+    state.PolygonMode(GL_POINT);
     glEnable(GL_PROGRAM_POINT_SIZE);
 
-    SetAttribute(shader);
+    BindMesh(shader, state);
 
-    shader.setUniformValue("PointColor", settings.GetVertexSettings().color);
-    shader.setUniformValue(
-        "RoundPoint", settings.GetVertexSettings().type == VertexType::kCircle);
-    shader.setUniformValue("PointSize", settings.GetVertexSettings().size);
+    shader.SetUniform(Uniform::kPointColor, settings.GetVertexSettings().color);
+    shader.SetUniform(Uniform::kRoundPoint, settings.GetVertexSettings().type ==
+                                                VertexType::kCircle);
+    shader.SetUniform(Uniform::kPointSize, settings.GetVertexSettings().size);
 
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr);
-
-    DisibleAttribute(shader);
+    DrawElements(state, instances);
   }
 }
 
 void Mesh::SetupMesh() {
-  VAO.create();
-  VAO.bind();
+  const void *vertex_data = vertices.constData();
+  qint64 vertex_bytes = vertices.size() * sizeof(Vertex);
+  if (compact) {
+    layout = ArenaBuffer::kCompactVertices;
+    vertex_data = compact_vertices.constData();
+    vertex_bytes = compact_vertices.size() * sizeof(CompactVertex);
+  }
+  const void *index_data = indices.constData();
+  qint64 index_bytes = indices.size() * sizeof(unsigned int);
+  if (index_type == GL_UNSIGNED_SHORT) {
+    index_data = short_indices.constData();
+    index_bytes = short_indices.size() * sizeof(quint16);
+  }
+  geometry = GeometryStore::Acquire(hash, layout, vertex_data, vertex_bytes,
+                                    index_data, index_bytes);
+  info.shared = geometry >= 0;
+  if (!info.shared) {
+    geometry = GeometryStore::Insert(hash, layout, vertex_data, vertex_bytes,
+                                     index_data, index_bytes,
+                                     lods[0].count / 3);
+  }
+  vertex_range = GeometryStore::GetVertexRange(geometry);
+  index_range = GeometryStore::GetIndexRange(geometry);
 
-  VBO.create();
-  VBO.setUsagePattern(QOpenGLBuffer::StaticDraw);
+  SetupMaterials();
+}
 
-  VBO.bind();
-  VBO.allocate(vertices.data(), vertices.size() * sizeof(Vertex));
+void Mesh::SetupMaterials() {
+  GLint alignment = 1;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  const int size = sizeof(MaterialBlock);
+  const int stride = (size + alignment - 1) / alignment * alignment;
 
-  EBO.create();
-  EBO.setUsagePattern(QOpenGLBuffer::StaticDraw);
+  material_blocks.clear();
+  for (int i = 0; i < parts.size(); ++i) {
+    parts[i].material_offset = i * stride;
+    material_blocks.push_back(MaterialBlock(parts[i].material));
+  }
 
-  EBO.bind();
-  EBO.allocate(indices.data(), indices.size() * sizeof(unsigned int));
+  material_buffer.create();
+  material_buffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+  material_buffer.bind();
+  material_buffer.allocate(parts.size() * stride);
+  for (int i = 0; i < parts.size(); ++i) {
+    material_buffer.write(parts[i].material_offset, &material_blocks[i],
+                          sizeof(MaterialBlock));
+  }
+  material_buffer.release();
+}
 
-  VAO.release();
-  VBO.release();
-  EBO.release();
+void Mesh::ReleaseData() {
+  vertices = QVector<Vertex>();
+  compact_vertices = QVector<CompactVertex>();
+  indices = QVector<unsigned int>();
+  short_indices = QVector<quint16>();
 }
 
-void Mesh::SetAttribute(QOpenGLShaderProgram &shader) {
-  VAO.bind();
-  VBO.bind();
-  EBO.bind();
+void Mesh::DrawElements(GlState &state, GLsizei instances, int low,
+                        int high) {
+  const qintptr index_size =
+      index_type == GL_UNSIGNED_SHORT ? sizeof(quint16) : sizeof(unsigned int);
+  const qintptr offset = BufferArena::GetOffset(index_range);
+  const GLint base_vertex = BufferArena::GetBaseVertex(vertex_range);
+  for (const IndexRange &it : ranges) {
+    const int first = std::max(it.first, low);
+    const int last = std::min(it.first + it.count, high);
+    if (first < last) {
+      state.Functions().glDrawElementsInstancedBaseVertex(
+          GL_TRIANGLES, last - first, index_type,
+          reinterpret_cast<const void *>(offset + first * index_size),
+          instances, base_vertex);
+    }
+  }
+}
 
-  shader.setAttributeBuffer(0, GL_FLOAT, 0, 3, sizeof(Vertex));
-  shader.enableAttributeArray(0);
+void Mesh::AppendCommands(int begin, int end, GLuint draw, GLuint instances,
+                          QVector<DrawCommand> &commands) const {
+  const qintptr index_size =
+      index_type == GL_UNSIGNED_SHORT ? sizeof(quint16) : sizeof(unsigned int);
+  const GLuint offset = BufferArena::GetOffset(index_range) / index_size;
+  const GLint base_vertex = BufferArena::GetBaseVertex(vertex_range);
+  const IndexRange run = GetRunRange(begin, end);
+  for (const IndexRange &it : ranges) {
+    const int first = std::max(it.first, run.first);
+    const int last = std::min(it.first + it.count, run.first + run.count);
+    if (first < last) {
+      commands.push_back({GLuint(last - first), instances, offset + first,
+                          base_vertex, draw});
+    }
+  }
+}
 
-  shader.setAttributeBuffer(1, GL_FLOAT, offsetof(Vertex, Normal), 3,
-                            sizeof(Vertex));
-  shader.enableAttributeArray(1);
+IndexRange Mesh::GetRunRange(int begin, int end) const {
+  if (begin == 0 && end == parts.size()) {
+    return {0, INT_MAX};
+  }
+  const int first = parts[begin].first;
+  return {first, parts[end - 1].first + parts[end - 1].count - first};
+}
 
-  shader.setAttributeBuffer(2, GL_FLOAT, offsetof(Vertex, TexCoords), 2,
-                            sizeof(Vertex));
-  shader.enableAttributeArray(2);
+void Mesh::DrawRun(GlState &state, int begin, int end, GLsizei instances) {
+  const IndexRange run = GetRunRange(begin, end);
+  DrawElements(state, instances, run.first, run.first + run.count);
+}
 
-  shader.setAttributeBuffer(3, GL_FLOAT, offsetof(Vertex, Tangent), 3,
-                            sizeof(Vertex));
-  shader.enableAttributeArray(3);
+void Mesh::BindSurface(const ModelSettings &settings, ShaderProgram &shader,
+                       GlState &state) {
+  BindMesh(shader, state);
+  if (settings.GetTextureSettings().type == TextureType::kWireFrame) {
+    state.PolygonMode(GL_LINE);
+  } else {
+    state.PolygonMode(GL_FILL);
+  }
+}
 
-  shader.setAttributeBuffer(4, GL_FLOAT, offsetof(Vertex, Bitangent), 3,
-                            sizeof(Vertex));
-  shader.enableAttributeArray(4);
+void Mesh::BindTextures(const MeshPart &part, ShaderProgram &shader,
+                        GlState &state) {
+  const QVector<TextureBinding> &textures = part.textures;
+  for (int i = 0; i < textures.size(); i++) {
+    QString name = textures[i].type;
+    if (name == "texture_ambient") {
+      shader.SetUniform(Uniform::kMapAmbient, i);
+    } else if (name == "texture_diffuse") {
+      shader.SetUniform(Uniform::kMapDiffuse, i);
+    } else if (name == "texture_specular") {
+      shader.SetUniform(Uniform::kMapSpecular, i);
+    } else if (name == "texture_normal") {
+      shader.SetUniform(Uniform::kMapNormal, i);
+    } else if (name == "texture_height") {
+      shader.SetUniform(Uniform::kMapHeight, i);
+    }
+    state.BindTexture(i, textures[i].texture->texture.textureId());
+  }
+}
 
-  shader.setUniformValue("skybox", 50);
+void Mesh::BindMaterial(const MeshPart &part, GlState &state) {
+  state.BindUniformRange(MaterialBlock::kBinding, material_buffer.bufferId(),
+                         part.material_offset, sizeof(MaterialBlock));
 }
 
-void Mesh::DisibleAttribute(QOpenGLShaderProgram &shader) {
-  shader.disableAttributeArray(0);
-  shader.disableAttributeArray(1);
-  shader.disableAttributeArray(2);
-  shader.disableAttributeArray(3);
-  shader.disableAttributeArray(4);
+void Mesh::BindMesh(ShaderProgram &shader, GlState &state) {
+  state.BindVertexArray(BufferArena::GetVertexArray(layout));
 
-  EBO.release();
-  VBO.release();
-  VAO.release();
+  shader.SetUniform(Uniform::kPositionOffset, position_offset);
+  shader.SetUniform(Uniform::kPositionScale, position_scale);
+  shader.SetUniform(Uniform::kPackedTangents, compact);
+  shader.SetUniform(Uniform::kSkybox, 50);
 }
 
 }  // namespace s21
@@ -4,21 +4,26 @@
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
+#include <QMatrix4x4>
 #include <QOpenGLBuffer>
-#include <QOpenGLExtraFunctions>
 #include <QOpenGLFunctions_4_1_Core>
-#include <QOpenGLShaderProgram>
-#include <QOpenGLTexture>
-#include <QOpenGLVertexArrayObject>
 #include <QOpenGLWidget>
+#include <QSharedPointer>
 #include <QString>
 #include <QVector2D>
 #include <QVector3D>
+#include <QVector4D>
 #include <QVector>
 #include <assimp/Importer.hpp>
+#include <climits>
 
+#include "buffer_arena.h"
+#include "cluster_culler.h"
+#include "gl_state.h"
 #include "mesh_information.h"
 #include "model_settings.h"
+#include "shader_program.h"
+#include "texture.h"
 
 namespace s21 {
 
@@ -30,19 +35,37 @@ struct Vertex {
   QVector3D Bitangent;
 };
 
-struct Texture {
-  QOpenGLTexture texture;
+// Quantized layout: positions as unorm16 inside the mesh bounds, normal and
+// tangent as snorm 10_10_10_2 (tangent w holds the bitangent sign), half UVs.
+struct CompactVertex {
+  quint16 Position[4];
+  quint32 Normal;
+  quint32 Tangent;
+  quint16 TexCoords[2];
+};
+
+// Range of one detail level inside the shared index buffer. error is the
+// largest geometric deviation from the full mesh in model units.
+struct MeshLod {
+  int first = 0;
+  int count = 0;
+  float error = 0.0f;
+  int first_cluster = 0;
+  int cluster_count = 0;
+};
+
+// A source mesh merged into a batch: its triangles inside the full detail
+// level and the number of vertices it brought.
+struct SubMesh {
+  QString name;
+  int first = 0;
+  int count = 0;
+  int vertex_count = 0;
+};
+
+struct TextureBinding {
   QString type;
-  QString path;
-  Texture() : texture(QOpenGLTexture::Target2D) {
-    texture.create();
-    texture.setWrapMode(QOpenGLTexture::DirectionS,
-                        QOpenGLTexture::MirroredRepeat);
-    texture.setWrapMode(QOpenGLTexture::DirectionT,
-                        QOpenGLTexture::MirroredRepeat);
-    texture.setMinMagFilters(QOpenGLTexture::LinearMipMapNearest,
-                             QOpenGLTexture::Nearest);
-  }
+  QSharedPointer<Texture> texture;
 };
 
 struct Material {
@@ -63,45 +86,186 @@ struct Material {
         Kd(QVector3D(1.0, 1.0, 1.0)),
         Ks(QVector3D(1.0, 1.0, 1.0)),
         Ke(QVector3D(0.0, 0.0, 0.0)) {}
+
+  bool operator==(const Material &other) const {
+    return Ka == other.Ka && Kd == other.Kd && Ks == other.Ks &&
+           Ke == other.Ke && Ns == other.Ns && Ni == other.Ni &&
+           refraction == other.refraction && reflection == other.reflection &&
+           roughness == other.roughness && d == other.d &&
+           illum == other.illum;
+  }
 };
 
-struct Mesh {
+// Material as the MaterialBlock uniform block of the lit shaders lays it out
+// in std140: every scalar fills the padding after a vec3.
+struct MaterialBlock {
+  // Follows the bindings of the light blocks.
+  static const int kBinding = 3;
+
+  QVector3D Ka;
+  float Ns;
+  QVector3D Kd;
+  float Ni;
+  QVector3D Ks;
+  float d;
+  QVector3D Ke;
+  float roughness;
+  float reflection;
+  float refraction;
+  float padding[2] = {};
+
+  explicit MaterialBlock(const Material &material);
+};
+static_assert(sizeof(MaterialBlock) == 80, "MaterialBlock does not match");
+
+// Layout of the commands read by glMultiDrawElementsIndirect.
+struct DrawCommand {
+  GLuint count;
+  GLuint instance_count;
+  GLuint first_index;
+  GLint base_vertex;
+  GLuint base_instance;
+};
+
+// One placement of a model in the instance buffer, read by the vertex
+// shaders as five RGBA32F texels: the transform by columns, then the color.
+// A color with positive alpha replaces the material colors of the copy.
+struct InstanceData {
+  float transform[16];
+  float color[4];
+
+  InstanceData();
+  InstanceData(const QMatrix4x4 &matrix, const QVector4D &tint);
+};
+static_assert(sizeof(InstanceData) == 80, "InstanceData does not match");
+
+struct MeshData;
+struct Mesh;
+
+// Selectable piece of a mesh with its own material and textures. The parts
+// of a batch share the buffers of their mesh.
+struct MeshPart {
  private:
-  QOpenGLVertexArrayObject VAO;
-  QOpenGLBuffer VBO, EBO;
+  friend struct Mesh;
 
-  QVector<Vertex> vertices;
-  QVector<unsigned int> indices;
-  QVector<Texture *> textures;
+  int first = 0;
+  int count = 0;
+  // Offset of the material inside the uniform buffer of the mesh.
+  int material_offset = 0;
+  QVector<TextureBinding> textures;
   Material material;
   Material save_material;
 
   MeshInfo info;
 
  public:
-  Mesh(const char *name, QVector<Vertex> &&vertices,
-       QVector<unsigned int> &&indices, QVector<Texture *> &&textures,
-       Material &&material);
-  ~Mesh();
-
   MeshInfo GetInfo() const;
   Material &GetMaterial();
+  const QVector<TextureBinding> &GetTextures() const;
 
-  void ChangeTexture(QImage img, QString &path);
+  void ChangeTexture(QImage img, const QString &path);
   void DelTexture();
+  void MirrorTexture();
   void SetDefaultMaterial();
 
-  void DrawTexture(const ModelSettings &settings, QOpenGLShaderProgram &shader);
-  void DrawMaterial(const ModelSettings &settings,
-                    QOpenGLShaderProgram &shader);
-  void DrawEdge(const ModelSettings &settings, QOpenGLShaderProgram &shader);
-  void DrawVertex(const ModelSettings &settings, QOpenGLShaderProgram &shader);
+  bool HasSameState(const MeshPart &other) const;
+};
 
+struct Mesh {
  private:
-  void SetupMesh();
+  // Vertices and indices live in the BufferArena, drawn through the vertex
+  // array of the layout. Meshes with the same content share the ranges
+  // through their GeometryStore handle.
+  ArenaBuffer layout = ArenaBuffer::kVertices;
+  quint64 hash = 0;
+  int geometry = -1;
+  int vertex_range = -1;
+  int index_range = -1;
+  // Uniform storage with one aligned MaterialBlock per part, and what was
+  // last written to it.
+  QOpenGLBuffer material_buffer;
+  QVector<MaterialBlock> material_blocks;
+
+  QVector<Vertex> vertices;
+  QVector<CompactVertex> compact_vertices;
+  QVector<unsigned int> indices;
+  QVector<quint16> short_indices;
+  GLsizei index_count = 0;
+  GLenum index_type = GL_UNSIGNED_INT;
+  QVector<MeshLod> lods;
+  int lod = 0;
+  ClusterCuller culler;
+  QVector<IndexRange> ranges;
+  QVector<MeshPart> parts;
+  bool uniform = true;
+
+  bool compact = false;
+  QVector3D position_offset;
+  QVector3D position_scale;
+
+  QVector3D center;
+  float radius = 0.0f;
 
-  void SetAttribute(QOpenGLShaderProgram &shader);
-  void DisibleAttribute(QOpenGLShaderProgram &shader);
+  MeshInfo info;
+
+ public:
+  Mesh(MeshData &&data, QVector<TextureBinding> &&textures);
+  ~Mesh();
+
+  MeshInfo GetInfo() const;
+  QVector<MeshPart> &GetParts();
+  QVector3D GetCenter() const;
+  ArenaBuffer GetLayout() const;
+  GLenum GetIndexType() const;
+  QVector3D GetPositionOffset() const;
+  QVector3D GetPositionScale() const;
+  // Bounds of the runs of neighbouring parts that share material and
+  // textures: run i covers the parts [runs[i], runs[i + 1]).
+  QVector<int> GetRuns() const;
+
+  // Picks the coarsest level whose error projects to at most threshold
+  // pixels and returns its triangle count. Coarser levels mix the triangles
+  // of all parts, so only the full level is used once their state differs.
+  int SelectLod(const QMatrix4x4 &model_view, const QMatrix4x4 &projection,
+                float height, float threshold);
+  // Keeps only the clusters of the selected level that can be visible.
+  void CullClusters(const QMatrix4x4 &model_view,
+                    const QMatrix4x4 &projection, bool cones,
+                    ClusterStats &stats);
+
+  // Rewrites the uniform ranges of the parts whose material was edited.
+  void UpdateMaterials();
+
+  // Draw the visible ranges of the run of parts [begin, end), instances
+  // times each.
+  void DrawTexture(const ModelSettings &settings, ShaderProgram &shader,
+                   GlState &state, int begin, int end, GLsizei instances);
+  void DrawMaterial(const ModelSettings &settings, ShaderProgram &shader,
+                    GlState &state, int begin, int end, GLsizei instances);
+  void DrawEdge(const ModelSettings &settings, ShaderProgram &shader,
+                GlState &state, GLsizei instances);
+  void DrawVertex(const ModelSettings &settings, ShaderProgram &shader,
+                  GlState &state, GLsizei instances);
+  // Appends one command per visible range of the run of parts [begin, end),
+  // drawing instances instances from the base instance draw.
+  void AppendCommands(int begin, int end, GLuint draw, GLuint instances,
+                      QVector<DrawCommand> &commands) const;
+
+ private:
+  void SetupMesh();
+  void SetupMaterials();
+  void ReleaseData();
+  // Index bounds of the run of parts [begin, end).
+  IndexRange GetRunRange(int begin, int end) const;
+  void DrawElements(GlState &state, GLsizei instances, int low = 0,
+                    int high = INT_MAX);
+  void DrawRun(GlState &state, int begin, int end, GLsizei instances);
+  void BindSurface(const ModelSettings &settings, ShaderProgram &shader,
+                   GlState &state);
+  void BindTextures(const MeshPart &part, ShaderProgram &shader,
+                    GlState &state);
+  void BindMaterial(const MeshPart &part, GlState &state);
+  void BindMesh(ShaderProgram &shader, GlState &state);
 };
 
 }  // namespace s21
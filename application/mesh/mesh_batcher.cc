@@ -0,0 +1,121 @@
+#include "mesh_batcher.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <algorithm>
+#include <vector>
+
+#include "global_settings.h"
+#include "index_format.h"
+#include "parallel.h"
+
+namespace s21 {
+
+namespace {
+
+QByteArray BatchKey(const MeshData &mesh) {
+  QByteArray key;
+  auto append = [&key](float value) {
+    key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+  };
+  const Material &m = mesh.material;
+  for (const QVector3D &it : {m.Ka, m.Kd, m.Ks, m.Ke}) {
+    append(it.x());
+    append(it.y());
+    append(it.z());
+  }
+  for (float it : {m.Ns, m.Ni, m.refraction, m.reflection, m.roughness, m.d}) {
+    append(it);
+  }
+  append(m.illum);
+  for (auto &it : mesh.textures) {
+    key.append(it.type.toUtf8()).append('\0');
+    key.append(it.path.toUtf8()).append('\0');
+  }
+  return key;
+}
+
+MeshData MergeGroup(QVector<MeshData> &meshes,
+                    const std::vector<int> &group) {
+  MeshData batch;
+  batch.name = meshes[group.front()].name;
+  batch.material = meshes[group.front()].material;
+  batch.textures = meshes[group.front()].textures;
+
+  int vertex_count = 0, index_count = 0;
+  for (auto it : group) {
+    vertex_count += meshes[it].vertices.size();
+    index_count += meshes[it].indices.size();
+  }
+  batch.vertices.reserve(vertex_count);
+  batch.indices.reserve(index_count);
+
+  for (auto it : group) {
+    MeshData &mesh = meshes[it];
+    const unsigned int base = batch.vertices.size();
+    batch.parts.push_back({mesh.name, int(batch.indices.size()),
+                           int(mesh.indices.size()),
+                           int(mesh.vertices.size())});
+    batch.vertices += mesh.vertices;
+    for (auto index : mesh.indices) {
+      batch.indices.push_back(base + index);
+    }
+    for (int j = 0; j < 3; ++j) {
+      batch.min_value[j] = std::min(batch.min_value[j], mesh.min_value[j]);
+      batch.max_value[j] = std::max(batch.max_value[j], mesh.max_value[j]);
+    }
+    mesh = MeshData();
+  }
+  return batch;
+}
+
+}  // namespace
+
+bool MeshBatcher::IsEnabled() {
+  return GlobalSetting::haveSettings("batchMeshes") &&
+         GlobalSetting::getSettings("batchMeshes").toBool();
+}
+
+void MeshBatcher::SetEnabled(bool enabled) {
+  GlobalSetting::setSettings("batchMeshes", enabled);
+}
+
+void MeshBatcher::Merge(QVector<MeshData> &meshes) {
+  const int limit = IndexFormat::kShortLimit;
+  std::vector<std::vector<int>> groups;
+  std::vector<int> group_vertices;
+  QHash<QByteArray, int> open;
+  for (int i = 0; i < meshes.size(); ++i) {
+    const MeshData &mesh = meshes[i];
+    if (mesh.indices.size() % 3 || mesh.vertices.size() >= limit) {
+      groups.push_back({i});
+      group_vertices.push_back(limit);
+      continue;
+    }
+    const QByteArray key = BatchKey(mesh);
+    auto it = open.find(key);
+    if (it == open.end() ||
+        group_vertices[it.value()] + mesh.vertices.size() > limit) {
+      it = open.insert(key, groups.size());
+      groups.emplace_back();
+      group_vertices.push_back(0);
+    }
+    groups[it.value()].push_back(i);
+    group_vertices[it.value()] += mesh.vertices.size();
+  }
+  if (groups.size() == size_t(meshes.size())) {
+    return;
+  }
+
+  QVector<MeshData> result(groups.size());
+  ParallelFor(groups.size(), [&](size_t i) {
+    if (groups[i].size() == 1) {
+      result[i] = std::move(meshes[groups[i].front()]);
+    } else {
+      result[i] = MergeGroup(meshes, groups[i]);
+    }
+  });
+  meshes = std::move(result);
+}
+
+}  // namespace s21
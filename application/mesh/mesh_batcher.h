@@ -0,0 +1,22 @@
+#ifndef MESH_BATCHER_H_
+#define MESH_BATCHER_H_
+
+#include "mesh_data.h"
+
+namespace s21 {
+
+class MeshBatcher {
+ public:
+  static bool IsEnabled();
+  static void SetEnabled(bool enabled);
+
+  // Merges meshes with equal material and textures into batches of at most
+  // IndexFormat::kShortLimit vertices. Every source mesh becomes a part that
+  // keeps its name and its triangle range. Meshes share one coordinate
+  // system, so no transform has to be baked into the vertices.
+  static void Merge(QVector<MeshData> &meshes);
+};
+
+}  // namespace s21
+
+#endif  // MESH_BATCHER_H_
@@ -0,0 +1,201 @@
+#include "mesh_clusters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace s21 {
+
+namespace {
+
+// Every edge of a closed surface has exactly two faces once vertices split
+// on seams are joined by position. Degenerate triangles are ignored.
+bool IsClosed(const MeshData &mesh, const MeshLod &level) {
+  std::vector<unsigned int> order(mesh.vertices.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  auto less = [&mesh](unsigned int a, unsigned int b) {
+    const QVector3D &p = mesh.vertices[a].Position;
+    const QVector3D &q = mesh.vertices[b].Position;
+    if (p.x() != q.x()) return p.x() < q.x();
+    if (p.y() != q.y()) return p.y() < q.y();
+    return p.z() < q.z();
+  };
+  std::sort(order.begin(), order.end(), less);
+  std::vector<unsigned int> canonical(order.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    const bool same = i && !less(order[i - 1], order[i]);
+    canonical[order[i]] = same ? canonical[order[i - 1]] : order[i];
+  }
+
+  std::vector<quint64> edges;
+  edges.reserve(level.count);
+  for (int i = level.first; i < level.first + level.count; i += 3) {
+    const quint64 corner[3] = {canonical[mesh.indices[i]],
+                               canonical[mesh.indices[i + 1]],
+                               canonical[mesh.indices[i + 2]]};
+    if (corner[0] == corner[1] || corner[1] == corner[2] ||
+        corner[0] == corner[2]) {
+      continue;
+    }
+    for (int j = 0; j < 3; ++j) {
+      const quint64 a = std::min(corner[j], corner[(j + 1) % 3]);
+      const quint64 b = std::max(corner[j], corner[(j + 1) % 3]);
+      edges.push_back(a << 32 | b);
+    }
+  }
+  std::sort(edges.begin(), edges.end());
+  for (size_t i = 0; i < edges.size(); i += 2) {
+    if (i + 1 == edges.size() || edges[i] != edges[i + 1] ||
+        (i + 2 < edges.size() && edges[i + 2] == edges[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Positive when the triangles wind counter-clockwise seen from outside.
+double SignedVolume(const MeshData &mesh, const MeshLod &level) {
+  double volume = 0.0;
+  for (int i = level.first; i < level.first + level.count; i += 3) {
+    const QVector3D &a = mesh.vertices[mesh.indices[i]].Position;
+    const QVector3D &b = mesh.vertices[mesh.indices[i + 1]].Position;
+    const QVector3D &c = mesh.vertices[mesh.indices[i + 2]].Position;
+    volume += QVector3D::dotProduct(a, QVector3D::crossProduct(b, c));
+  }
+  return volume;
+}
+
+MeshCluster CreateCluster(const MeshData &mesh, int first, int count,
+                          bool cones, float orientation) {
+  MeshCluster cluster;
+  cluster.first = first;
+  cluster.count = count;
+
+  QVector3D low(INFINITY, INFINITY, INFINITY);
+  QVector3D high(-INFINITY, -INFINITY, -INFINITY);
+  for (int i = first; i < first + count; ++i) {
+    const QVector3D &p = mesh.vertices[mesh.indices[i]].Position;
+    for (int j = 0; j < 3; ++j) {
+      low[j] = std::min(low[j], p[j]);
+      high[j] = std::max(high[j], p[j]);
+    }
+  }
+  cluster.center = (low + high) / 2.0f;
+  for (int i = first; i < first + count; ++i) {
+    const QVector3D &p = mesh.vertices[mesh.indices[i]].Position;
+    cluster.radius =
+        std::max(cluster.radius, cluster.center.distanceToPoint(p));
+  }
+
+  std::vector<QVector3D> normals;
+  normals.reserve(count / 3);
+  for (int i = first; i < first + count; i += 3) {
+    const QVector3D &a = mesh.vertices[mesh.indices[i]].Position;
+    const QVector3D &b = mesh.vertices[mesh.indices[i + 1]].Position;
+    const QVector3D &c = mesh.vertices[mesh.indices[i + 2]].Position;
+    const QVector3D normal = QVector3D::crossProduct(b - a, c - a);
+    if (normal.length() > 0.0f) {
+      normals.push_back(normal.normalized() * orientation);
+      cluster.cone_axis += normals.back();
+    }
+  }
+  cluster.cone_axis.normalize();
+  if (!cones || normals.empty() || cluster.cone_axis.length() <= 0.0f) {
+    return cluster;
+  }
+  float spread = 1.0f;
+  for (auto &it : normals) {
+    spread = std::min(spread, QVector3D::dotProduct(it, cluster.cone_axis));
+  }
+  if (spread > 0.0f) {
+    cluster.cone_cutoff = std::sqrt(1.0f - spread * spread);
+  }
+  return cluster;
+}
+
+void BuildLevel(MeshData &mesh, MeshLod &level, bool cones,
+                float orientation) {
+  const int triangle_count = level.count / 3;
+  const unsigned int *indices = mesh.indices.constData() + level.first;
+
+  std::vector<unsigned int> offsets(mesh.vertices.size() + 1, 0);
+  for (int i = 0; i < level.count; ++i) {
+    ++offsets[indices[i] + 1];
+  }
+  for (size_t i = 0; i + 1 < offsets.size(); ++i) {
+    offsets[i + 1] += offsets[i];
+  }
+  std::vector<unsigned int> adjacency(level.count);
+  std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+  for (int i = 0; i < level.count; ++i) {
+    adjacency[fill[indices[i]]++] = i / 3;
+  }
+
+  std::vector<char> taken(triangle_count, 0);
+  std::vector<unsigned int> queue, cluster;
+  std::vector<IndexRange> ranges;
+  QVector<unsigned int> result;
+  result.reserve(level.count);
+  for (int seed = 0; seed < triangle_count; ++seed) {
+    if (taken[seed]) continue;
+    queue.assign(1, seed);
+    taken[seed] = 1;
+    cluster.clear();
+    for (size_t head = 0; head < queue.size() &&
+                          cluster.size() < size_t(MeshClusters::kMaxTriangles);
+         ++head) {
+      const unsigned int triangle = queue[head];
+      cluster.push_back(triangle);
+      for (int j = 0; j < 3; ++j) {
+        const unsigned int v = indices[3 * triangle + j];
+        for (unsigned int k = offsets[v]; k < offsets[v + 1]; ++k) {
+          if (!taken[adjacency[k]]) {
+            taken[adjacency[k]] = 1;
+            queue.push_back(adjacency[k]);
+          }
+        }
+      }
+    }
+    for (size_t i = cluster.size(); i < queue.size(); ++i) {
+      taken[queue[i]] = 0;
+    }
+
+    std::sort(cluster.begin(), cluster.end());
+    const int first = level.first + result.size();
+    for (auto it : cluster) {
+      result << indices[3 * it] << indices[3 * it + 1] << indices[3 * it + 2];
+    }
+    ranges.push_back({first, int(3 * cluster.size())});
+  }
+  std::copy(result.begin(), result.end(),
+            mesh.indices.begin() + level.first);
+
+  level.first_cluster = mesh.clusters.size();
+  level.cluster_count = ranges.size();
+  for (const IndexRange &it : ranges) {
+    mesh.clusters.push_back(
+        CreateCluster(mesh, it.first, it.count, cones, orientation));
+  }
+}
+
+}  // namespace
+
+void MeshClusters::Build(MeshData &mesh) {
+  if (mesh.indices.size() % 3) {
+    return;
+  }
+  if (mesh.lods.isEmpty()) {
+    mesh.lods.push_back({0, int(mesh.indices.size()), 0.0f});
+  }
+  const bool closed = IsClosed(mesh, mesh.lods[0]);
+  const float orientation = SignedVolume(mesh, mesh.lods[0]) < 0.0 ? -1 : 1;
+  for (auto &it : mesh.lods) {
+    if (it.count / 3 > kMaxTriangles) {
+      BuildLevel(mesh, it, closed, orientation);
+    }
+  }
+}
+
+}  // namespace s21
@@ -0,0 +1,20 @@
+#ifndef MESH_CLUSTERS_H_
+#define MESH_CLUSTERS_H_
+
+#include "mesh_data.h"
+
+namespace s21 {
+
+class MeshClusters {
+ public:
+  static const int kMaxTriangles = 128;
+
+  // Regroups the triangles of every level into spatially compact clusters,
+  // keeping their relative order, and records bounding spheres and normal
+  // cones. Cones stay disabled unless the mesh is closed.
+  static void Build(MeshData &mesh);
+};
+
+}  // namespace s21
+
+#endif  // MESH_CLUSTERS_H_
@@ -0,0 +1,42 @@
+#ifndef MESH_DATA_H_
+#define MESH_DATA_H_
+
+#include <QString>
+#include <QVector3D>
+#include <QVector>
+
+#include "mesh.h"
+
+namespace s21 {
+
+struct TextureRef {
+  QString type;
+  QString path;
+};
+
+struct MeshData {
+  QString name;
+
+  QVector<Vertex> vertices;
+  QVector<CompactVertex> compact_vertices;
+  QVector<unsigned int> indices;
+  QVector<quint16> short_indices;
+  QVector<MeshLod> lods;
+  QVector<MeshCluster> clusters;
+  QVector<SubMesh> parts;
+  QVector<TextureRef> textures;
+  Material material;
+
+  QVector3D min_value;
+  QVector3D max_value;
+  // Content hash of the packed geometry, see GeometryStore::Hash.
+  quint64 hash = 0;
+
+  MeshData()
+      : min_value{QVector3D(INFINITY, INFINITY, INFINITY)},
+        max_value{QVector3D(-INFINITY, -INFINITY, -INFINITY)} {}
+};
+
+}  // namespace s21
+
+#endif  // MESH_DATA_H_
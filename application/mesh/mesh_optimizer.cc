@@ -0,0 +1,213 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "global_settings.h"
+
+namespace s21 {
+
+namespace {
+
+struct Adjacency {
+  std::vector<unsigned int> offsets;
+  std::vector<unsigned int> triangles;
+};
+
+Adjacency BuildAdjacency(const QVector<unsigned int> &indices,
+                         size_t vertex_count) {
+  Adjacency adjacency;
+  adjacency.offsets.assign(vertex_count + 1, 0);
+  for (auto it : indices) {
+    ++adjacency.offsets[it + 1];
+  }
+  for (size_t i = 0; i < vertex_count; ++i) {
+    adjacency.offsets[i + 1] += adjacency.offsets[i];
+  }
+
+  adjacency.triangles.resize(indices.size());
+  std::vector<unsigned int> fill(adjacency.offsets.begin(),
+                                 adjacency.offsets.end() - 1);
+  for (int i = 0; i < indices.size(); ++i) {
+    adjacency.triangles[fill[indices[i]]++] = i / 3;
+  }
+  return adjacency;
+}
+
+QVector<unsigned int> Tipsify(const QVector<unsigned int> &indices,
+                              size_t vertex_count, int cache_size) {
+  const Adjacency adjacency = BuildAdjacency(indices, vertex_count);
+  std::vector<unsigned int> live(vertex_count);
+  for (size_t i = 0; i < vertex_count; ++i) {
+    live[i] = adjacency.offsets[i + 1] - adjacency.offsets[i];
+  }
+  std::vector<unsigned int> timestamps(vertex_count, 0);
+  std::vector<char> emitted(indices.size() / 3, 0);
+  std::vector<unsigned int> dead_end, candidates;
+
+  QVector<unsigned int> result;
+  result.reserve(indices.size());
+  unsigned int time = cache_size + 1;
+  size_t cursor = 0;
+
+  auto next_vertex = [&]() -> long long {
+    long long best = -1;
+    long long best_priority = -1;
+    for (auto v : candidates) {
+      if (!live[v]) continue;
+      long long priority = 0;
+      if (time - timestamps[v] + 2 * live[v] <= unsigned(cache_size)) {
+        priority = time - timestamps[v];
+      }
+      if (priority > best_priority) {
+        best_priority = priority;
+        best = v;
+      }
+    }
+    while (best < 0 && !dead_end.empty()) {
+      const unsigned int v = dead_end.back();
+      dead_end.pop_back();
+      if (live[v]) best = v;
+    }
+    for (; best < 0 && cursor < vertex_count; ++cursor) {
+      if (live[cursor]) best = cursor;
+    }
+    return best;
+  };
+
+  for (long long fan = next_vertex(); fan >= 0; fan = next_vertex()) {
+    candidates.clear();
+    for (unsigned int i = adjacency.offsets[fan];
+         i < adjacency.offsets[fan + 1]; ++i) {
+      const unsigned int triangle = adjacency.triangles[i];
+      if (emitted[triangle]) continue;
+      emitted[triangle] = 1;
+      for (int j = 0; j < 3; ++j) {
+        const unsigned int v = indices[3 * triangle + j];
+        result.push_back(v);
+        dead_end.push_back(v);
+        candidates.push_back(v);
+        --live[v];
+        if (time - timestamps[v] > unsigned(cache_size)) {
+          timestamps[v] = time++;
+        }
+      }
+    }
+  }
+  return result;
+}
+
+// Splits the order into clusters at cold cache starts and draws the
+// clusters facing away from the mesh centre first.
+QVector<unsigned int> SortClusters(const QVector<unsigned int> &indices,
+                                   const QVector<Vertex> &vertices,
+                                   int cache_size) {
+  const int triangle_count = indices.size() / 3;
+  std::vector<int> starts;
+  std::vector<long long> entered(vertices.size(), -cache_size - 1);
+  long long misses = 0;
+  for (int t = 0; t < triangle_count; ++t) {
+    int cold = 0;
+    for (int j = 0; j < 3; ++j) {
+      const unsigned int v = indices[3 * t + j];
+      if (misses - entered[v] > cache_size) {
+        entered[v] = misses++;
+        ++cold;
+      }
+    }
+    if (cold == 3 || starts.empty()) starts.push_back(t);
+  }
+  starts.push_back(triangle_count);
+
+  QVector3D center;
+  double total_area = 0.0;
+  const int cluster_count = starts.size() - 1;
+  std::vector<QVector3D> centroids(cluster_count), normals(cluster_count);
+  for (int c = 0; c < cluster_count; ++c) {
+    float area = 0.0f;
+    for (int t = starts[c]; t < starts[c + 1]; ++t) {
+      const QVector3D &a = vertices[indices[3 * t]].Position;
+      const QVector3D &b = vertices[indices[3 * t + 1]].Position;
+      const QVector3D &d = vertices[indices[3 * t + 2]].Position;
+      const QVector3D normal = QVector3D::crossProduct(b - a, d - a);
+      const float weight = normal.length();
+      normals[c] += normal;
+      centroids[c] += (a + b + d) * (weight / 3.0f);
+      area += weight;
+    }
+    center += centroids[c];
+    total_area += area;
+    centroids[c] = area > 0.0f ? centroids[c] / area : centroids[c];
+  }
+  if (total_area > 0.0) center /= total_area;
+
+  std::vector<float> scores(cluster_count);
+  std::vector<int> order(cluster_count);
+  for (int c = 0; c < cluster_count; ++c) {
+    scores[c] =
+        QVector3D::dotProduct(centroids[c] - center, normals[c].normalized());
+    order[c] = c;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&scores](int a, int b) { return scores[a] > scores[b]; });
+
+  QVector<unsigned int> result;
+  result.reserve(indices.size());
+  for (auto c : order) {
+    for (int i = 3 * starts[c]; i < 3 * starts[c + 1]; ++i) {
+      result.push_back(indices[i]);
+    }
+  }
+  return result;
+}
+
+void RemapVertices(MeshData &mesh) {
+  std::vector<int> remap(mesh.vertices.size(), -1);
+  QVector<Vertex> vertices;
+  vertices.reserve(mesh.vertices.size());
+  for (auto &it : mesh.indices) {
+    if (remap[it] < 0) {
+      remap[it] = vertices.size();
+      vertices.push_back(mesh.vertices[it]);
+    }
+    it = remap[it];
+  }
+  mesh.vertices = std::move(vertices);
+}
+
+}  // namespace
+
+bool MeshOptimizer::IsEnabled() {
+  return GlobalSetting::haveSettings("optimizeMeshes") &&
+         GlobalSetting::getSettings("optimizeMeshes").toBool();
+}
+
+void MeshOptimizer::SetEnabled(bool enabled) {
+  GlobalSetting::setSettings("optimizeMeshes", enabled);
+}
+
+VertexCacheStats MeshOptimizer::Analyze(const MeshData &mesh) {
+  VertexCacheStats stats;
+  std::vector<long long> entered(mesh.vertices.size(), -kCacheSize - 1);
+  std::vector<char> used(mesh.vertices.size(), 0);
+  for (auto it : mesh.indices) {
+    if (stats.misses - entered[it] > kCacheSize) {
+      entered[it] = stats.misses++;
+    }
+    stats.vertices += !used[it];
+    used[it] = 1;
+  }
+  stats.triangles = mesh.indices.size() / 3;
+  return stats;
+}
+
+void MeshOptimizer::Optimize(MeshData &mesh) {
+  if (mesh.indices.size() < 3 || mesh.indices.size() % 3) {
+    return;
+  }
+  mesh.indices = Tipsify(mesh.indices, mesh.vertices.size(), kCacheSize);
+  mesh.indices = SortClusters(mesh.indices, mesh.vertices, kCacheSize);
+  RemapVertices(mesh);
+}
+
+}  // namespace s21
@@ -0,0 +1,25 @@
+#ifndef MESH_OPTIMIZER_H_
+#define MESH_OPTIMIZER_H_
+
+#include "mesh_data.h"
+#include "mesh_information.h"
+
+namespace s21 {
+
+class MeshOptimizer {
+ public:
+  static const int kCacheSize = 16;
+
+  static bool IsEnabled();
+  static void SetEnabled(bool enabled);
+
+  // Simulates a FIFO post-transform cache of kCacheSize entries.
+  static VertexCacheStats Analyze(const MeshData &mesh);
+  // Tipsify triangle order, outward-first cluster order against overdraw
+  // and a first-use vertex order for fetch locality.
+  static void Optimize(MeshData &mesh);
+};
+
+}  // namespace s21
+
+#endif  // MESH_OPTIMIZER_H_
@@ -0,0 +1,323 @@
+#include "mesh_simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "global_settings.h"
+
+namespace s21 {
+
+namespace {
+
+struct Quadric {
+  double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+  double b2 = 0.0, bc = 0.0, bd = 0.0;
+  double c2 = 0.0, cd = 0.0;
+  double d2 = 0.0;
+  double weight = 0.0;
+
+  void AddPlane(const QVector3D &normal, double d, double area) {
+    const double a = normal.x(), b = normal.y(), c = normal.z();
+    a2 += area * a * a;
+    ab += area * a * b;
+    ac += area * a * c;
+    ad += area * a * d;
+    b2 += area * b * b;
+    bc += area * b * c;
+    bd += area * b * d;
+    c2 += area * c * c;
+    cd += area * c * d;
+    d2 += area * d * d;
+    weight += area;
+  }
+
+  void Add(const Quadric &other) {
+    a2 += other.a2;
+    ab += other.ab;
+    ac += other.ac;
+    ad += other.ad;
+    b2 += other.b2;
+    bc += other.bc;
+    bd += other.bd;
+    c2 += other.c2;
+    cd += other.cd;
+    d2 += other.d2;
+    weight += other.weight;
+  }
+
+  double Error(const QVector3D &point) const {
+    const double x = point.x(), y = point.y(), z = point.z();
+    const double error = a2 * x * x + b2 * y * y + c2 * z * z +
+                         2.0 * (ab * x * y + ac * x * z + bc * y * z) +
+                         2.0 * (ad * x + bd * y + cd * z) + d2;
+    return std::fabs(error);
+  }
+};
+
+struct Collapse {
+  unsigned int from;
+  unsigned int to;
+  double cost;
+};
+
+struct Adjacency {
+  std::vector<unsigned int> offsets;
+  std::vector<unsigned int> triangles;
+};
+
+Adjacency BuildAdjacency(const std::vector<unsigned int> &indices,
+                         size_t vertex_count) {
+  Adjacency adjacency;
+  adjacency.offsets.assign(vertex_count + 1, 0);
+  for (auto it : indices) {
+    ++adjacency.offsets[it + 1];
+  }
+  for (size_t i = 0; i < vertex_count; ++i) {
+    adjacency.offsets[i + 1] += adjacency.offsets[i];
+  }
+
+  adjacency.triangles.resize(indices.size());
+  std::vector<unsigned int> fill(adjacency.offsets.begin(),
+                                 adjacency.offsets.end() - 1);
+  for (size_t i = 0; i < indices.size(); ++i) {
+    adjacency.triangles[fill[indices[i]]++] = i / 3;
+  }
+  return adjacency;
+}
+
+// Maps every vertex to the first vertex with the same position. A position
+// shared by several vertices carries a normal or UV seam.
+std::vector<unsigned int> WeldPositions(const QVector<Vertex> &vertices,
+                                        std::vector<char> &locked) {
+  std::vector<unsigned int> order(vertices.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  auto less = [&vertices](unsigned int a, unsigned int b) {
+    const QVector3D &p = vertices[a].Position;
+    const QVector3D &q = vertices[b].Position;
+    if (p.x() != q.x()) return p.x() < q.x();
+    if (p.y() != q.y()) return p.y() < q.y();
+    if (p.z() != q.z()) return p.z() < q.z();
+    return a < b;
+  };
+  std::sort(order.begin(), order.end(), less);
+
+  std::vector<unsigned int> canonical(vertices.size());
+  for (size_t i = 0; i < order.size();) {
+    size_t j = i + 1;
+    while (j < order.size() &&
+           vertices[order[j]].Position == vertices[order[i]].Position) {
+      ++j;
+    }
+    for (size_t k = i; k < j; ++k) {
+      canonical[order[k]] = order[i];
+    }
+    if (j - i > 1) locked[order[i]] = 1;
+    i = j;
+  }
+  return canonical;
+}
+
+// Locks both ends of every edge that does not have exactly two faces.
+void LockBorders(const std::vector<unsigned int> &welded,
+                 std::vector<char> &locked) {
+  std::vector<quint64> edges;
+  edges.reserve(welded.size());
+  for (size_t i = 0; i < welded.size(); i += 3) {
+    for (size_t j = 0; j < 3; ++j) {
+      quint64 a = welded[i + j], b = welded[i + (j + 1) % 3];
+      if (a > b) std::swap(a, b);
+      edges.push_back(a << 32 | b);
+    }
+  }
+  std::sort(edges.begin(), edges.end());
+  for (size_t i = 0; i < edges.size();) {
+    size_t j = i + 1;
+    while (j < edges.size() && edges[j] == edges[i]) ++j;
+    if (j - i != 2) {
+      locked[edges[i] >> 32] = 1;
+      locked[edges[i] & 0xffffffffu] = 1;
+    }
+    i = j;
+  }
+}
+
+std::vector<Quadric> BuildQuadrics(const QVector<Vertex> &vertices,
+                                   const std::vector<unsigned int> &welded) {
+  std::vector<Quadric> quadrics(vertices.size());
+  for (size_t i = 0; i < welded.size(); i += 3) {
+    const QVector3D &a = vertices[welded[i]].Position;
+    const QVector3D &b = vertices[welded[i + 1]].Position;
+    const QVector3D &c = vertices[welded[i + 2]].Position;
+    QVector3D normal = QVector3D::crossProduct(b - a, c - a);
+    const float area = normal.length();
+    if (area <= 0.0f) continue;
+    normal /= area;
+    const double d = -QVector3D::dotProduct(normal, a);
+    for (size_t j = 0; j < 3; ++j) {
+      quadrics[welded[i + j]].AddPlane(normal, d, area);
+    }
+  }
+  return quadrics;
+}
+
+bool FlipsTriangle(const QVector<Vertex> &vertices,
+                   const std::vector<unsigned int> &welded,
+                   const Adjacency &adjacency, unsigned int from,
+                   unsigned int to) {
+  const QVector3D &target = vertices[to].Position;
+  for (unsigned int i = adjacency.offsets[from];
+       i < adjacency.offsets[from + 1]; ++i) {
+    const unsigned int *corner = &welded[3 * adjacency.triangles[i]];
+    if (corner[0] == to || corner[1] == to || corner[2] == to) continue;
+
+    QVector3D before[3], after[3];
+    for (int j = 0; j < 3; ++j) {
+      before[j] = vertices[corner[j]].Position;
+      after[j] = corner[j] == from ? target : before[j];
+    }
+    const QVector3D old_normal =
+        QVector3D::crossProduct(before[1] - before[0], before[2] - before[0]);
+    const QVector3D new_normal =
+        QVector3D::crossProduct(after[1] - after[0], after[2] - after[0]);
+    if (QVector3D::dotProduct(old_normal, new_normal) <=
+        0.25f * old_normal.length() * new_normal.length()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+bool MeshSimplifier::IsEnabled() {
+  return GlobalSetting::haveSettings("buildLods") &&
+         GlobalSetting::getSettings("buildLods").toBool();
+}
+
+void MeshSimplifier::SetEnabled(bool enabled) {
+  GlobalSetting::setSettings("buildLods", enabled);
+}
+
+int MeshSimplifier::GetBudget() {
+  if (!GlobalSetting::haveSettings("triangleBudget")) {
+    return 0;
+  }
+  return GlobalSetting::getSettings("triangleBudget").toInt();
+}
+
+void MeshSimplifier::SetBudget(int budget) {
+  GlobalSetting::setSettings("triangleBudget", budget);
+}
+
+float MeshSimplifier::Simplify(const QVector<Vertex> &vertices,
+                               QVector<unsigned int> &indices,
+                               int target_count) {
+  std::vector<char> locked(vertices.size(), 0);
+  const std::vector<unsigned int> canonical = WeldPositions(vertices, locked);
+
+  std::vector<unsigned int> welded(indices.size());
+  for (int i = 0; i < indices.size(); ++i) {
+    welded[i] = canonical[indices[i]];
+  }
+  LockBorders(welded, locked);
+  std::vector<Quadric> quadrics = BuildQuadrics(vertices, welded);
+
+  double error = 0.0;
+  std::vector<char> touched(vertices.size());
+  std::vector<long long> wedge(vertices.size());
+  std::vector<Collapse> collapses;
+  while (indices.size() > target_count) {
+    const Adjacency adjacency = BuildAdjacency(welded, vertices.size());
+
+    collapses.clear();
+    for (size_t i = 0; i < welded.size(); ++i) {
+      const unsigned int a = welded[i];
+      const unsigned int b = welded[i % 3 == 2 ? i - 2 : i + 1];
+      if (locked[a] || a == b) continue;
+      Quadric quadric = quadrics[a];
+      quadric.Add(quadrics[b]);
+      collapses.push_back({a, b, quadric.Error(vertices[b].Position)});
+    }
+    std::sort(collapses.begin(), collapses.end(),
+              [](const Collapse &a, const Collapse &b) {
+                return a.cost < b.cost;
+              });
+
+    std::fill(touched.begin(), touched.end(), 0);
+    std::fill(wedge.begin(), wedge.end(), -1);
+    int removed = 0;
+    const int needed = (indices.size() - target_count) / 3;
+    for (const Collapse &it : collapses) {
+      if (removed >= needed) break;
+      if (touched[it.from] || touched[it.to]) continue;
+      if (FlipsTriangle(vertices, welded, adjacency, it.from, it.to)) {
+        continue;
+      }
+
+      for (unsigned int i = adjacency.offsets[it.from];
+           i < adjacency.offsets[it.from + 1]; ++i) {
+        const unsigned int triangle = adjacency.triangles[i];
+        for (int j = 0; j < 3; ++j) {
+          const unsigned int corner = welded[3 * triangle + j];
+          touched[corner] = 1;
+          if (corner == it.to) {
+            wedge[it.from] = indices[3 * triangle + j];
+            ++removed;
+          }
+        }
+      }
+      quadrics[it.to].Add(quadrics[it.from]);
+      const double weight = quadrics[it.to].weight;
+      if (weight > 0.0) {
+        error = std::max(error, std::sqrt(it.cost / weight));
+      }
+    }
+    if (!removed) break;
+
+    QVector<unsigned int> result;
+    result.reserve(indices.size());
+    for (int i = 0; i < indices.size(); i += 3) {
+      unsigned int corner[3];
+      for (int j = 0; j < 3; ++j) {
+        const unsigned int from = welded[i + j];
+        corner[j] = wedge[from] < 0 ? indices[i + j] : wedge[from];
+      }
+      const unsigned int a = canonical[corner[0]];
+      const unsigned int b = canonical[corner[1]];
+      const unsigned int c = canonical[corner[2]];
+      if (a != b && b != c && a != c) {
+        result << corner[0] << corner[1] << corner[2];
+      }
+    }
+    indices = std::move(result);
+
+    welded.resize(indices.size());
+    for (int i = 0; i < indices.size(); ++i) {
+      welded[i] = canonical[indices[i]];
+    }
+  }
+  return error;
+}
+
+void MeshSimplifier::BuildLods(MeshData &mesh) {
+  const int count = mesh.indices.size();
+  if (count / 3 < kMinTriangles || count % 3) {
+    return;
+  }
+  mesh.lods.push_back({0, count, 0.0f});
+
+  QVector<unsigned int> level = mesh.indices;
+  float error = 0.0f;
+  while (mesh.lods.size() < kMaxLods && level.size() / 3 >= kMinTriangles) {
+    const int previous = level.size();
+    error += Simplify(mesh.vertices, level, previous / 6 * 3);
+    if (level.size() > previous * 3 / 4) break;
+    mesh.lods.push_back({int(mesh.indices.size()), int(level.size()), error});
+    mesh.indices += level;
+  }
+}
+
+}  // namespace s21
@@ -0,0 +1,31 @@
+#ifndef MESH_SIMPLIFIER_H_
+#define MESH_SIMPLIFIER_H_
+
+#include "mesh_data.h"
+
+namespace s21 {
+
+class MeshSimplifier {
+ public:
+  static const int kMaxLods = 5;
+  static const int kMinTriangles = 256;
+
+  static bool IsEnabled();
+  static void SetEnabled(bool enabled);
+  // Triangles drawn per frame over all models, 0 means no limit.
+  static int GetBudget();
+  static void SetBudget(int budget);
+
+  // Quadric-error edge collapse down to target_count indices. Collapses only
+  // move a vertex onto an existing one, so the result indexes the same
+  // vertex array. Seam and border vertices are never moved. Returns the
+  // largest collapse error as a distance in model units.
+  static float Simplify(const QVector<Vertex> &vertices,
+                        QVector<unsigned int> &indices, int target_count);
+  // Appends every coarser level to mesh.indices and records the ranges.
+  static void BuildLods(MeshData &mesh);
+};
+
+}  // namespace s21
+
+#endif  // MESH_SIMPLIFIER_H_
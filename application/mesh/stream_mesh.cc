@@ -0,0 +1,125 @@
+#include "stream_mesh.h"
+
+#include <algorithm>
+
+#include "mesh.h"
+
+namespace s21 {
+
+namespace {
+
+const qint64 kMinCapacity = 1 << 20;
+const int kStride = ImportStream::kVertexSize * sizeof(float);
+
+}  // namespace
+
+StreamMesh::StreamMesh()
+    : m_vbo_(QOpenGLBuffer::VertexBuffer),
+      m_material_(QOpenGLBuffer::VertexBuffer),
+      m_min_value_{QVector3D(INFINITY, INFINITY, INFINITY)},
+      m_max_value_{QVector3D(-INFINITY, -INFINITY, -INFINITY)} {}
+
+StreamMesh::~StreamMesh() {
+  m_vbo_.destroy();
+  m_material_.destroy();
+  m_vao_.destroy();
+}
+
+void StreamMesh::Append(QOpenGLFunctions_4_1_Core &gl,
+                        const QVector<StreamBatch> &batches) {
+  qint64 bytes = 0;
+  for (const StreamBatch &it : batches) {
+    bytes += it.vertices.size() * sizeof(float);
+  }
+  Reserve(gl, m_size_ + bytes);
+
+  m_vbo_.bind();
+  for (const StreamBatch &it : batches) {
+    const int size = it.vertices.size() * sizeof(float);
+    if (size) {
+      m_vbo_.write(m_size_, it.vertices.constData(), size);
+      m_size_ += size;
+    }
+    m_faces_ += it.faces;
+    for (int j = 0; j < 3; ++j) {
+      m_min_value_[j] = std::min(m_min_value_[j], it.min_value[j]);
+      m_max_value_[j] = std::max(m_max_value_[j], it.max_value[j]);
+    }
+  }
+  m_vbo_.release();
+}
+
+void StreamMesh::Reserve(QOpenGLFunctions_4_1_Core &gl, qint64 bytes) {
+  if (bytes <= m_capacity_) return;
+  const qint64 capacity = std::max({bytes, 2 * m_capacity_, kMinCapacity});
+
+  QOpenGLBuffer buffer(QOpenGLBuffer::VertexBuffer);
+  buffer.create();
+  buffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+  buffer.bind();
+  buffer.allocate(capacity);
+  if (m_size_) {
+    gl.glBindBuffer(GL_COPY_READ_BUFFER, m_vbo_.bufferId());
+    gl.glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_ARRAY_BUFFER, 0, 0,
+                           m_size_);
+    gl.glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  }
+  buffer.release();
+
+  m_vbo_.destroy();
+  m_vbo_ = buffer;
+  m_capacity_ = capacity;
+  if (m_vao_.isCreated()) {
+    SetupVertexArray(gl);
+  }
+}
+
+void StreamMesh::SetupVertexArray(QOpenGLFunctions_4_1_Core &gl) {
+  if (!m_vao_.isCreated()) {
+    m_vao_.create();
+  }
+  m_vao_.bind();
+  m_vbo_.bind();
+  gl.glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, kStride,
+                           reinterpret_cast<const void *>(0));
+  gl.glEnableVertexAttribArray(0);
+  gl.glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, kStride,
+                           reinterpret_cast<const void *>(3 * sizeof(float)));
+  gl.glEnableVertexAttribArray(1);
+  m_vao_.release();
+  m_vbo_.release();
+}
+
+void StreamMesh::Draw(GlState &state, ShaderProgram &shader) {
+  if (!m_size_) return;
+  QOpenGLFunctions_4_1_Core &gl = state.Functions();
+  if (!m_vao_.isCreated()) {
+    SetupVertexArray(gl);
+
+    const MaterialBlock material{Material()};
+    m_material_.create();
+    m_material_.bind();
+    m_material_.allocate(&material, sizeof(material));
+    m_material_.release();
+  }
+
+  shader.SetUniform(Uniform::kPositionOffset, QVector3D(0.0f, 0.0f, 0.0f));
+  shader.SetUniform(Uniform::kPositionScale, QVector3D(1.0f, 1.0f, 1.0f));
+  shader.SetUniform(Uniform::kPackedTangents, false);
+
+  state.BindVertexArray(m_vao_.objectId());
+  state.BindUniformRange(MaterialBlock::kBinding, m_material_.bufferId(), 0,
+                         sizeof(MaterialBlock));
+  state.PolygonMode(GL_FILL);
+  gl.glDrawArrays(GL_TRIANGLES, 0, m_size_ / kStride);
+}
+
+qint64 StreamMesh::GetFaces() const { return m_faces_; }
+
+bool StreamMesh::IsEmpty() const { return !m_size_; }
+
+QVector3D StreamMesh::GetCenter() const {
+  return (m_min_value_ + m_max_value_) / 2.0f;
+}
+
+}  // namespace s21
@@ -0,0 +1,50 @@
+#ifndef STREAM_MESH_H_
+#define STREAM_MESH_H_
+
+#include <QOpenGLBuffer>
+#include <QOpenGLFunctions_4_1_Core>
+#include <QOpenGLVertexArrayObject>
+#include <QVector3D>
+
+#include "gl_state.h"
+#include "import_stream.h"
+#include "shader_program.h"
+
+namespace s21 {
+
+// Unindexed preview of a model that is still loading. Batches are appended
+// to a vertex buffer that doubles its capacity on the GPU when full, so the
+// triangles already uploaded are never sent again.
+class StreamMesh {
+ public:
+  StreamMesh();
+  ~StreamMesh();
+
+  void Append(QOpenGLFunctions_4_1_Core &gl,
+              const QVector<StreamBatch> &batches);
+  void Draw(GlState &state, ShaderProgram &shader);
+
+  qint64 GetFaces() const;
+  bool IsEmpty() const;
+  QVector3D GetCenter() const;
+
+ private:
+  void Reserve(QOpenGLFunctions_4_1_Core &gl, qint64 bytes);
+
+  void SetupVertexArray(QOpenGLFunctions_4_1_Core &gl);
+
+  QOpenGLVertexArrayObject m_vao_;
+  QOpenGLBuffer m_vbo_;
+  // Default material for the lit shaders' MaterialBlock.
+  QOpenGLBuffer m_material_;
+  qint64 m_capacity_ = 0;
+  qint64 m_size_ = 0;
+  qint64 m_faces_ = 0;
+
+  QVector3D m_min_value_;
+  QVector3D m_max_value_;
+};
+
+}  // namespace s21
+
+#endif  // STREAM_MESH_H_
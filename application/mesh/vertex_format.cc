@@ -0,0 +1,97 @@
+#include "vertex_format.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "global_settings.h"
+
+namespace s21 {
+
+namespace {
+
+quint32 PackSnorm(const QVector3D &value, float w) {
+  auto pack = [](float x, float range) {
+    const float clamped = std::min(std::max(x, -1.0f), 1.0f);
+    return static_cast<quint32>(std::lround(clamped * range));
+  };
+  return (pack(value.x(), 511.0f) & 0x3FF) |
+         (pack(value.y(), 511.0f) & 0x3FF) << 10 |
+         (pack(value.z(), 511.0f) & 0x3FF) << 20 |
+         (pack(w, 1.0f) & 0x3) << 30;
+}
+
+quint16 PackHalf(float value) {
+  quint32 bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const quint32 sign = (bits >> 16) & 0x8000;
+  const quint32 raw_exponent = (bits >> 23) & 0xFF;
+  quint32 mantissa = bits & 0x7FFFFF;
+  if (raw_exponent == 0xFF) {
+    return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+  }
+
+  const int exponent = int(raw_exponent) - 127 + 15;
+  if (exponent >= 31) {
+    return sign | 0x7C00;
+  }
+  if (exponent <= 0) {
+    if (exponent < -10) return sign;
+    mantissa |= 0x800000;
+    const int shift = 14 - exponent;
+    const quint32 half = (mantissa >> shift) + ((mantissa >> (shift - 1)) & 1);
+    return sign | half;
+  }
+  const quint32 half = (quint32(exponent) << 10) | (mantissa >> 13);
+  return sign | (half + ((mantissa >> 12) & 1));
+}
+
+quint16 PackUnorm16(float value, float offset, float scale) {
+  const long q = std::lround((value - offset) * scale);
+  return static_cast<quint16>(std::min(std::max(q, 0L), 65535L));
+}
+
+}  // namespace
+
+bool VertexFormat::IsCompact() {
+  return GlobalSetting::haveSettings("compactVertices") &&
+         GlobalSetting::getSettings("compactVertices").toBool();
+}
+
+void VertexFormat::SetCompact(bool compact) {
+  GlobalSetting::setSettings("compactVertices", compact);
+}
+
+void VertexFormat::Pack(MeshData &mesh) {
+  QVector3D scale;
+  for (int i = 0; i < 3; ++i) {
+    const float extent = mesh.max_value[i] - mesh.min_value[i];
+    scale[i] = extent > 0.0f ? 65535.0f / extent : 0.0f;
+  }
+
+  mesh.compact_vertices.resize(mesh.vertices.size());
+  CompactVertex *target = mesh.compact_vertices.data();
+  for (auto &it : mesh.vertices) {
+    for (int i = 0; i < 3; ++i) {
+      target->Position[i] =
+          PackUnorm16(it.Position[i], mesh.min_value[i], scale[i]);
+    }
+    target->Position[3] = 0;
+
+    const QVector3D normal = it.Normal.normalized();
+    const QVector3D tangent = it.Tangent.normalized();
+    const float sign =
+        QVector3D::dotProduct(QVector3D::crossProduct(normal, tangent),
+                              it.Bitangent) < 0.0f
+            ? -1.0f
+            : 1.0f;
+    target->Normal = PackSnorm(normal, 0.0f);
+    target->Tangent = PackSnorm(tangent, sign);
+
+    target->TexCoords[0] = PackHalf(it.TexCoords.x());
+    target->TexCoords[1] = PackHalf(it.TexCoords.y());
+    ++target;
+  }
+  mesh.vertices = QVector<Vertex>();
+}
+
+}  // namespace s21
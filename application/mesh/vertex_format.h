@@ -0,0 +1,19 @@
+#ifndef VERTEX_FORMAT_H_
+#define VERTEX_FORMAT_H_
+
+#include "mesh_data.h"
+
+namespace s21 {
+
+class VertexFormat {
+ public:
+  static bool IsCompact();
+  static void SetCompact(bool compact);
+
+  // Fills compact_vertices from vertices and releases the float copy.
+  static void Pack(MeshData &mesh);
+};
+
+}  // namespace s21
+
+#endif  // VERTEX_FORMAT_H_
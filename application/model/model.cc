@@ -2,38 +2,100 @@
 
 #include <QOpenGLTexture>
 
+#include <QFileInfo>
+#include <QSet>
+#include <assimp/ProgressHandler.hpp>
+#include <cmath>
+
+#include "geometry_store.h"
+#include "index_format.h"
+#include "memory_usage.h"
+#include "mesh_batcher.h"
+#include "mesh_cache.h"
+#include "mesh_clusters.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "obj_importer.h"
+#include "parallel.h"
+#include "texture_cache.h"
+#include "vertex_format.h"
+
 namespace s21 {
 
-Model::Model(QString path)
-    : m_settings_{ModelSettings(path)}, info_{new ModelInfo(path)} {
-  Assimp::Importer import;
-  const aiScene *scene = import.ReadFile(
-      path.toLocal8Bit(),
-      aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace |
-          aiProcess_GenNormals | aiProcess_JoinIdenticalVertices);
-  if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE ||
-      !scene->mRootNode) {
-    emit Error(QString("ERROR::ASSIMP::" + QString(import.GetErrorString())));
-    return;
+namespace {
+
+const unsigned int kImportFlags =
+    aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace |
+    aiProcess_GenNormals | aiProcess_JoinIdenticalVertices;
+
+class AssimpProgress : public Assimp::ProgressHandler {
+ public:
+  explicit AssimpProgress(ImportProgress &progress) : m_progress_{progress} {}
+
+  bool Update(float percentage) override {
+    if (percentage >= 0.0f) {
+      m_progress_.SetBytes(m_progress_.GetTotalBytes() * percentage);
+    }
+    return !m_progress_.IsCancelled();
   }
 
-  info_->GetDirectory().cdUp();
-  ProcessNode(scene->mRootNode, scene);
-  for (auto it : info_->m_meshes) {
-    info_->AddMeshVerices(it->GetInfo().vertices_count);
-    info_->AddMeshFace(it->GetInfo().face_count);
+ private:
+  ImportProgress &m_progress_;
+};
+
+const size_t kBoundsBlock = 8;
+
+void CopyVectors(const aiVector3D *source, unsigned int count,
+                 Vertex *target, QVector3D Vertex::*member) {
+  for (unsigned int i = 0; i < count; ++i) {
+    target[i].*member = QVector3D(source[i].x, source[i].y, source[i].z);
   }
 }
 
-Model::~Model() {
-  for (auto &it : info_->textures) {
-    it->texture.destroy();
-    delete it;
+void ComputeBounds(const aiVector3D *positions, unsigned int count,
+                   QVector3D &min_value, QVector3D &max_value) {
+  if (!count) return;
+  const float *values = &positions->x;
+  float low[3 * kBoundsBlock], high[3 * kBoundsBlock];
+  std::fill(low, low + 3 * kBoundsBlock, INFINITY);
+  std::fill(high, high + 3 * kBoundsBlock, -INFINITY);
+
+  size_t i = 0;
+  for (; i + kBoundsBlock <= count; i += kBoundsBlock) {
+    const float *block = values + 3 * i;
+    for (size_t j = 0; j < 3 * kBoundsBlock; ++j) {
+      low[j] = block[j] < low[j] ? block[j] : low[j];
+      high[j] = block[j] > high[j] ? block[j] : high[j];
+    }
+  }
+  for (; i < count; ++i) {
+    for (size_t j = 0; j < 3; ++j) {
+      low[j] = std::min(low[j], values[3 * i + j]);
+      high[j] = std::max(high[j], values[3 * i + j]);
+    }
   }
 
+  for (size_t j = 0; j < 3 * kBoundsBlock; ++j) {
+    min_value[j % 3] = std::min(min_value[j % 3], low[j]);
+    max_value[j % 3] = std::max(max_value[j % 3], high[j]);
+  }
+}
+
+// The transform of an instance, which is stored by columns.
+QMatrix4x4 Placement(const InstanceData &instance) {
+  return QMatrix4x4(instance.transform).transposed();
+}
+
+}  // namespace
+
+Model::Model(QString path)
+    : m_settings_{ModelSettings(path)}, info_{new ModelInfo(path)} {}
+
+Model::~Model() {
   for (auto &it : info_->m_meshes) {
     delete it;
   }
+  BufferArena::Remove(m_instance_range_);
   m_settings_.SaveModelSetting();
   delete info_;
 }
@@ -54,82 +116,59 @@ void Model::TransformMatrix() {
   info_->m_matrix.scale(scale.STotal);
 }
 
-void Model::DrawTexture(QOpenGLShaderProgram &shader) {
-  if (m_settings_.GetSurfaceSettings() == SurfaceType::kTexture) {
-    TransformMatrix();
-    for (Mesh *mesh : info_->m_meshes) {
-      mesh->DrawTexture(m_settings_, shader);
-    }
-  }
-}
-
-void Model::DrawMaterial(QOpenGLShaderProgram &shader) {
-  if (m_settings_.GetSurfaceSettings() == SurfaceType::kMaterial) {
-    TransformMatrix();
-    for (Mesh *mesh : info_->m_meshes) {
-      mesh->DrawMaterial(m_settings_, shader);
-    }
-  }
-}
-
-void Model::DrawEdge(QOpenGLShaderProgram &shader) {
-  TransformMatrix();
+void Model::UpdateMaterials() {
+  if (m_material_revision_ == m_revision_) return;
+  m_material_revision_ = m_revision_;
   for (Mesh *mesh : info_->m_meshes) {
-    mesh->DrawEdge(m_settings_, shader);
+    mesh->UpdateMaterials();
   }
 }
 
-void Model::DrawVertex(QOpenGLShaderProgram &shader) {
-  TransformMatrix();
-  for (Mesh *mesh : info_->m_meshes) {
-    mesh->DrawVertex(m_settings_, shader);
-  }
-}
+const QVector<Mesh *> &Model::GetMeshes() const { return info_->m_meshes; }
 
 void Model::ChangeTexture(QImage img, QString &path) {
-  QOpenGLTexture texture(img);
+  ++m_revision_;
   if (m_current_mesh_) {
     m_current_mesh_->ChangeTexture(img, path);
   } else {
-    for (auto &it : info_->m_meshes) {
+    for (auto &it : m_parts_) {
       it->ChangeTexture(img, path);
     }
   }
 }
 
 void Model::DelTexture() {
+  ++m_revision_;
   if (m_current_mesh_) {
     m_current_mesh_->DelTexture();
   } else {
-    for (auto &it : info_->m_meshes) {
+    for (auto &it : m_parts_) {
       it->DelTexture();
     }
   }
 }
 
 void Model::MirrorTexture() {
-  for (auto &it : info_->textures) {
-    if (it->path != "") {
-      it->texture.destroy();
-      it->texture.create();
-      QImage data(info_->GetDirectory().filePath(it->path));
-      it->texture.setData(data.mirrored());
-    }
+  ++m_revision_;
+  for (auto &it : m_parts_) {
+    it->MirrorTexture();
   }
 }
 
 void Model::SetDefaultMaterial() {
-  for (auto &it : info_->m_meshes) {
+  ++m_revision_;
+  for (auto &it : m_parts_) {
     it->SetDefaultMaterial();
   }
 }
 
 void Model::ChangeAmbient(QColor color) {
+  ++m_revision_;
   if (m_current_mesh_) {
     m_current_mesh_->GetMaterial().Ka =
         QVector3D(color.redF(), color.greenF(), color.blueF());
   } else {
-    for (auto &it : info_->m_meshes) {
+    for (auto &it : m_parts_) {
       it->GetMaterial().Ka =
           QVector3D(color.redF(), color.greenF(), color.blueF());
     }
@@ -137,12 +176,13 @@ void Model::ChangeAmbient(QColor color) {
 }
 
 void Model::ChangeDiffuse(QColor color) {
+  ++m_revision_;
   if (m_current_mesh_) {
     m_current_mesh_->GetMaterial().Kd =
         QVector3D(color.redF(), color.greenF(), color.blueF());
 
   } else {
-    for (auto &it : info_->m_meshes) {
+    for (auto &it : m_parts_) {
       it->GetMaterial().Kd =
           QVector3D(color.redF(), color.greenF(), color.blueF());
     }
@@ -150,12 +190,13 @@ void Model::ChangeDiffuse(QColor color) {
 }
 
 void Model::ChangeSpecular(QColor color) {
+  ++m_revision_;
   if (m_current_mesh_) {
     m_current_mesh_->GetMaterial().Ks =
         QVector3D(color.redF(), color.greenF(), color.blueF());
 
   } else {
-    for (auto &it : info_->m_meshes) {
+    for (auto &it : m_parts_) {
       it->GetMaterial().Ks =
           QVector3D(color.redF(), color.greenF(), color.blueF());
     }
@@ -163,62 +204,164 @@ void Model::ChangeSpecular(QColor color) {
 }
 
 void Model::ChangeShine(double shine) {
+  ++m_revision_;
   if (m_current_mesh_) {
     m_current_mesh_->GetMaterial().Ns = shine;
   } else {
-    for (auto &it : info_->m_meshes) {
+    for (auto &it : m_parts_) {
       it->GetMaterial().Ns = shine;
     }
   }
 }
 
 void Model::ChangeOpacity(double opacity) {
+  ++m_revision_;
   if (m_current_mesh_) {
     m_current_mesh_->GetMaterial().d = opacity;
   } else {
-    for (auto &it : info_->m_meshes) {
+    for (auto &it : m_parts_) {
       it->GetMaterial().d = opacity;
     }
   }
 }
 
 void Model::ChangeReflection(double reflect) {
+  ++m_revision_;
   if (m_current_mesh_) {
     m_current_mesh_->GetMaterial().reflection = reflect;
   } else {
-    for (auto &it : info_->m_meshes) {
+    for (auto &it : m_parts_) {
       it->GetMaterial().reflection = reflect;
     }
   }
 }
 
 void Model::ChangeRoughness(double roughness) {
+  ++m_revision_;
   if (m_current_mesh_) {
     m_current_mesh_->GetMaterial().roughness = roughness;
   } else {
-    for (auto &it : info_->m_meshes) {
+    for (auto &it : m_parts_) {
       it->GetMaterial().roughness = roughness;
     }
   }
 }
 
 void Model::ChangeRefraction(double refract) {
+  ++m_revision_;
   if (m_current_mesh_) {
     m_current_mesh_->GetMaterial().refraction = refract;
   } else {
-    for (auto &it : info_->m_meshes) {
+    for (auto &it : m_parts_) {
       it->GetMaterial().refraction = refract;
     }
   }
 }
 
-Mesh *Model::GetCurrentMesh() { return m_current_mesh_; }
+void Model::SetInstances(const QVector<InstanceData> &instances) {
+  ++m_revision_;
+  m_instances_ = instances;
+  if (m_instances_.isEmpty()) {
+    m_instances_.push_back(InstanceData());
+  }
+  m_instances_dirty_ = true;
+}
+
+void Model::SetInstanceGrid(int count) {
+  count = std::max(count, 1);
+  const int side = std::ceil(std::sqrt(count));
+  const QVector3D step = (info_->max_value - info_->min_value) * 1.25f;
+  QVector<InstanceData> instances;
+  instances.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    QMatrix4x4 matrix;
+    matrix.translate(i % side * step.x(), 0.0f, i / side * step.z());
+    instances.push_back(
+        InstanceData(matrix, i ? m_instance_color_ : QVector4D()));
+  }
+  SetInstances(instances);
+}
+
+void Model::SetInstanceColor(QColor color) {
+  ++m_revision_;
+  m_instance_color_ = QVector4D();
+  if (color.isValid()) {
+    m_instance_color_ =
+        QVector4D(color.redF(), color.greenF(), color.blueF(), 1.0f);
+  }
+  for (int i = 1; i < m_instances_.size(); ++i) {
+    m_instances_[i] = InstanceData(Placement(m_instances_[i]),
+                                   m_instance_color_);
+  }
+  m_instances_dirty_ = true;
+}
+
+int Model::GetInstanceCount() const { return m_instances_.size(); }
+
+GLint Model::GetInstanceBase() const {
+  return BufferArena::GetBaseInstance(m_instance_range_);
+}
+
+void Model::UpdateInstances() {
+  if (!m_instances_dirty_) return;
+  m_instances_dirty_ = false;
+  BufferArena::Remove(m_instance_range_);
+  m_instance_range_ =
+      BufferArena::Add(ArenaBuffer::kInstances, m_instances_.constData(),
+                       m_instances_.size() * sizeof(InstanceData));
+}
+
+qint64 Model::SelectLods(const QMatrix4x4 &view, const QMatrix4x4 &projection,
+                         float height, float threshold) {
+  TransformMatrix();
+  QMatrix4x4 model_view = view * info_->m_matrix;
+  if (m_instances_.size() > 1) {
+    // The nearest copy decides the level of every copy.
+    const QVector3D center = (info_->min_value + info_->max_value) / 2.0f;
+    int nearest = 0;
+    float distance = INFINITY;
+    for (int i = 0; i < m_instances_.size(); ++i) {
+      const QMatrix4x4 placement = Placement(m_instances_[i]);
+      const float it = model_view.map(placement.map(center)).lengthSquared();
+      if (it < distance) {
+        distance = it;
+        nearest = i;
+      }
+    }
+    model_view *= Placement(m_instances_[nearest]);
+  }
+  qint64 triangles = 0;
+  for (Mesh *mesh : info_->m_meshes) {
+    triangles += mesh->SelectLod(model_view, projection, height, threshold);
+  }
+  m_lod_triangles_ = triangles * m_instances_.size();
+  return m_lod_triangles_;
+}
+
+void Model::CullClusters(const QMatrix4x4 &view,
+                         const QMatrix4x4 &projection, ClusterStats &stats) {
+  // The clusters are culled against a single placement, so copies keep
+  // their whole level.
+  if (m_instances_.size() > 1) {
+    stats.triangles += m_lod_triangles_;
+    return;
+  }
+  TransformMatrix();
+  const QMatrix4x4 model_view = view * info_->m_matrix;
+  const bool cones =
+      m_settings_.GetTextureSettings().type == TextureType::kSurface;
+  for (Mesh *mesh : info_->m_meshes) {
+    mesh->CullClusters(model_view, projection, cones, stats);
+  }
+}
+
+MeshPart *Model::GetCurrentMesh() { return m_current_mesh_; }
 
 void Model::ChangeCurentMesh(int i) {
   if (i < 0) {
     m_current_mesh_ = nullptr;
   } else {
-    m_current_mesh_ = info_->m_meshes[i];
+    m_current_mesh_ = m_parts_[i];
   }
 }
 
@@ -226,95 +369,225 @@ const QMatrix4x4 Model::GetModelMatrix() const { return info_->m_matrix; }
 
 ModelSettings &Model::GetSettings() { return m_settings_; }
 
+quint64 Model::GetRevision() const {
+  return m_revision_ + m_settings_.GetRevision();
+}
+
 ModelInfo Model::GetInfo() { return *info_; }
 
 QStringList Model::GetMeshesName() {
   QStringList names;
-  for (auto &it : info_->m_meshes) {
+  for (auto &it : m_parts_) {
     names << it->GetInfo().name;
   }
   return names;
 }
 
-Model *Model::createModel(QString path) { return new Model(path); }
+bool Model::Import(ImportProgress &progress) {
+  const QString path = info_->GetName();
+  progress.SetTotalBytes(QFileInfo(path).size());
+
+  const bool optimize = MeshOptimizer::IsEnabled();
+  MeshCache cache(path, optimize ? kImportFlags | aiProcess_ImproveCacheLocality
+                                 : kImportFlags);
+  if (cache.Load(m_data_)) {
+    progress.SetBytes(progress.GetTotalBytes());
+    progress.SetTotalMeshes(m_data_.size());
+    progress.AddMeshes(m_data_.size());
+  } else {
+    if (!ImportFile(path, progress)) {
+      return false;
+    }
+    if (optimize) {
+      OptimizeMeshes();
+    }
+    cache.Store(m_data_);
+  }
 
-void Model::Destroy() { delete this; }
+  PrepareMeshes();
+  return LoadImages(progress);
+}
 
-void Model::ProcessNode(aiNode *node, const aiScene *scene) {
-  for (unsigned int i = 0; i < node->mNumMeshes; i++) {
-    aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-    info_->m_meshes.push_back(ProcessMesh(mesh, scene));
+void Model::SetStream(ImportStream *stream) { m_stream_ = stream; }
+
+bool Model::ImportFile(const QString &path, ImportProgress &progress) {
+  ObjImporter importer(path);
+  importer.SetTextureCallback(
+      [this](const QString &path) { m_texture_loader_.Prefetch(path); });
+  importer.SetStream(m_stream_);
+  if (ObjImporter::CanRead(path) && importer.Read(m_data_, progress)) {
+    return true;
+  }
+  if (progress.IsCancelled()) {
+    return false;
   }
+  progress.SetBytes(0);
+  m_data_.clear();
+  return ImportScene(path, m_data_, progress);
+}
 
-  for (unsigned int i = 0; i < node->mNumChildren; i++) {
-    ProcessNode(node->mChildren[i], scene);
+void Model::OptimizeMeshes() {
+  std::vector<VertexCacheStats> stats(m_data_.size());
+  ParallelFor(m_data_.size(), [this, &stats](size_t i) {
+    stats[i] = MeshOptimizer::Analyze(m_data_[i]);
+    MeshOptimizer::Optimize(m_data_[i]);
+  });
+
+  VertexCacheStats before;
+  for (auto &it : stats) {
+    before.Add(it);
   }
+  info_->SetCacheStatsBefore(before);
 }
 
-Mesh *Model::ProcessMesh(aiMesh *mesh, const aiScene *scene) {
-  QVector<Vertex> vertices;
-  LoadVertexData(mesh, vertices);
+void Model::PrepareMeshes() {
+  if (IndexFormat::IsSplit()) {
+    IndexFormat::Split(m_data_);
+  }
+  if (MeshBatcher::IsEnabled()) {
+    MeshBatcher::Merge(m_data_);
+  }
+  // The cache stats are taken from the final index order, before the LOD
+  // levels are appended to it.
+  std::vector<VertexCacheStats> stats(m_data_.size());
+  const bool lods = MeshSimplifier::IsEnabled();
+  const bool compact = VertexFormat::IsCompact();
+  ParallelFor(m_data_.size(), [this, &stats, lods, compact](size_t i) {
+    stats[i] = MeshOptimizer::Analyze(m_data_[i]);
+    if (lods) MeshSimplifier::BuildLods(m_data_[i]);
+    MeshClusters::Build(m_data_[i]);
+    if (compact) VertexFormat::Pack(m_data_[i]);
+    IndexFormat::Pack(m_data_[i]);
+    m_data_[i].hash = GeometryStore::Hash(m_data_[i]);
+  });
+  VertexCacheStats after;
+  for (auto &it : stats) {
+    after.Add(it);
+  }
+  info_->SetCacheStats(after);
+}
 
-  QVector<unsigned int> indices;
-  LoadIndicesData(mesh, indices);
+void Model::Upload() {
+  info_->m_meshes.reserve(m_data_.size());
+  for (auto &it : m_data_) {
+    for (int j = 0; j < 3; ++j) {
+      info_->min_value[j] = std::min(info_->min_value[j], it.min_value[j]);
+      info_->max_value[j] = std::max(info_->max_value[j], it.max_value[j]);
+    }
+    info_->m_meshes.push_back(CreateMesh(std::move(it)));
+  }
+  QSet<quint64> hashes;
+  for (auto it : info_->m_meshes) {
+    for (auto &part : it->GetParts()) {
+      m_parts_.push_back(&part);
+    }
+    info_->AddMeshVerices(it->GetInfo().vertices_count);
+    info_->AddMeshFace(it->GetInfo().face_count);
+    info_->AddVertexBytes(it->GetInfo().vertex_bytes);
+    info_->AddIndexBytes(it->GetInfo().index_bytes);
+    info_->AddLodBytes(it->GetInfo().lod_bytes);
+    if (it->GetInfo().shared) {
+      info_->AddSharedBytes(it->GetInfo().vertex_bytes +
+                            it->GetInfo().index_bytes +
+                            it->GetInfo().lod_bytes);
+    }
+    if (!hashes.contains(it->GetInfo().hash)) {
+      hashes.insert(it->GetInfo().hash);
+      info_->AddUniqueFaces(it->GetInfo().face_count);
+    }
+  }
+  m_data_.clear();
+  m_texture_loader_.Clear();
+  info_->SetPeakMemory(PeakMemoryUsage());
+}
 
-  QVector<Texture *> textures;
-  LoadTextureData(scene, mesh, textures);
+Model *Model::createModel(QString path) { return new Model(path); }
 
-  Material material;
-  LoadMaterial(scene, mesh, material);
+void Model::Destroy() { delete this; }
 
-  return new Mesh(mesh->mName.C_Str(), std::move(vertices), std::move(indices),
-                  std::move(textures), std::move(material));
-}
+bool Model::ImportScene(const QString &path, QVector<MeshData> &meshes,
+                        ImportProgress &progress) {
+  Assimp::Importer import;
+  import.SetProgressHandler(new AssimpProgress(progress));
+  const aiScene *scene = import.ReadFile(path.toLocal8Bit(), kImportFlags);
+  if (progress.IsCancelled()) {
+    return false;
+  }
+  if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE ||
+      !scene->mRootNode) {
+    emit Error(QString("ERROR::ASSIMP::" + QString(import.GetErrorString())));
+    return false;
+  }
 
-void Model::LoadVertexData(aiMesh *mesh, QVector<Vertex> &vertices) {
-  for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
-    Vertex vertex;
+  PrefetchImages(scene);
+  ProcessNode(scene->mRootNode, scene, meshes, progress);
+  return !progress.IsCancelled();
+}
 
-    vertex.Position.setX(mesh->mVertices[i].x);
-    vertex.Position.setY(mesh->mVertices[i].y);
-    vertex.Position.setZ(mesh->mVertices[i].z);
+void Model::ProcessNode(aiNode *node, const aiScene *scene,
+                        QVector<MeshData> &meshes, ImportProgress &progress) {
+  QVector<aiMesh *> sources;
+  CollectMeshes(node, scene, sources);
+  progress.SetTotalMeshes(sources.size());
+
+  const int first = meshes.size();
+  meshes.resize(first + sources.size());
+  MeshData *data = meshes.data() + first;
+  ParallelFor(sources.size(), [&](size_t i) {
+    if (progress.IsCancelled()) return;
+    data[i] = ProcessMesh(sources[i], scene);
+    progress.AddMeshes(1);
+  });
+}
 
-    for (int j = 0; j < 3; ++j) {
-      if (vertex.Position[j] < info_->min_value[j]) {
-        info_->min_value[j] = vertex.Position[j];
-      }
-      if (vertex.Position[j] > info_->max_value[j]) {
-        info_->max_value[j] = vertex.Position[j];
-      }
-    }
+void Model::CollectMeshes(aiNode *node, const aiScene *scene,
+                          QVector<aiMesh *> &meshes) {
+  for (unsigned int i = 0; i < node->mNumMeshes; i++) {
+    meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+  }
 
-    if (mesh->mNormals) {
-      vertex.Normal.setX(mesh->mNormals[i].x);
-      vertex.Normal.setY(mesh->mNormals[i].y);
-      vertex.Normal.setZ(mesh->mNormals[i].z);
-    }
+  for (unsigned int i = 0; i < node->mNumChildren; i++) {
+    CollectMeshes(node->mChildren[i], scene, meshes);
+  }
+}
 
-    if (mesh->mTextureCoords[0]) {
-      vertex.TexCoords.setX(mesh->mTextureCoords[0][i].x);
-      vertex.TexCoords.setY(mesh->mTextureCoords[0][i].y);
-    } else {
-      vertex.TexCoords = QVector2D(0, 0);
-    }
+MeshData Model::ProcessMesh(aiMesh *mesh, const aiScene *scene) {
+  MeshData data;
+  data.name = mesh->mName.C_Str();
+  LoadVertexData(mesh, data);
+  LoadIndicesData(mesh, data.indices);
+  LoadTextureData(scene, mesh, data.textures);
+  LoadMaterial(scene, mesh, data.material);
+  return data;
+}
 
-    if (mesh->mTangents) {
-      vertex.Tangent.setX(mesh->mTangents[i].x);
-      vertex.Tangent.setY(mesh->mTangents[i].y);
-      vertex.Tangent.setZ(mesh->mTangents[i].z);
-    }
+void Model::LoadVertexData(aiMesh *mesh, MeshData &data) {
+  const unsigned int count = mesh->mNumVertices;
+  data.vertices.resize(count);
+  Vertex *vertices = data.vertices.data();
 
-    if (mesh->mBitangents) {
-      vertex.Bitangent.setX(mesh->mBitangents[i].x);
-      vertex.Bitangent.setY(mesh->mBitangents[i].y);
-      vertex.Bitangent.setZ(mesh->mBitangents[i].z);
+  CopyVectors(mesh->mVertices, count, vertices, &Vertex::Position);
+  if (mesh->mNormals) {
+    CopyVectors(mesh->mNormals, count, vertices, &Vertex::Normal);
+  }
+  if (mesh->mTextureCoords[0]) {
+    const aiVector3D *uvs = mesh->mTextureCoords[0];
+    for (unsigned int i = 0; i < count; ++i) {
+      vertices[i].TexCoords = QVector2D(uvs[i].x, uvs[i].y);
     }
-
-    vertices.push_back(vertex);
   }
+  if (mesh->mTangents) {
+    CopyVectors(mesh->mTangents, count, vertices, &Vertex::Tangent);
+  }
+  if (mesh->mBitangents) {
+    CopyVectors(mesh->mBitangents, count, vertices, &Vertex::Bitangent);
+  }
+
+  ComputeBounds(mesh->mVertices, count, data.min_value, data.max_value);
 }
 
 void Model::LoadIndicesData(aiMesh *mesh, QVector<unsigned int> &indices) {
+  indices.reserve(3 * mesh->mNumFaces);
   for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
     aiFace face = mesh->mFaces[i];
     for (unsigned int j = 0; j < face.mNumIndices; j++) {
@@ -324,63 +597,17 @@ void Model::LoadIndicesData(aiMesh *mesh, QVector<unsigned int> &indices) {
 }
 
 void Model::LoadTextureData(const aiScene *scene, aiMesh *mesh,
-                            QVector<Texture *> &textures) {
+                            QVector<TextureRef> &textures) {
   aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
 
-  if (material->GetTextureCount(aiTextureType_AMBIENT)) {
-    QVector<Texture *> ambientMaps = LoadMaterialTextures(
-        material, aiTextureType_AMBIENT, "texture_ambient");
-    std::copy(ambientMaps.begin(), ambientMaps.end(),
-              std::back_inserter(textures));
-  } else {
-    Texture *texture = new Texture;
-    QImage data(1, 1, QImage::Format_RGB32);
-    data.fill(Qt::white);
-    texture->texture.setData(data);
-    texture->type = "texture_ambient";
-    texture->path = "";
-    textures.push_back(texture);
-    info_->textures.push_back(texture);
-  }
-
-  if (material->GetTextureCount(aiTextureType_DIFFUSE)) {
-    QVector<Texture *> diffuseMaps = LoadMaterialTextures(
-        material, aiTextureType_DIFFUSE, "texture_diffuse");
-    std::copy(diffuseMaps.begin(), diffuseMaps.end(),
-              std::back_inserter(textures));
-  } else {
-    Texture *texture = new Texture;
-    QImage data(1, 1, QImage::Format_RGB32);
-    data.fill(Qt::white);
-    texture->texture.setData(data);
-    texture->type = "texture_diffuse";
-    texture->path = "";
-    textures.push_back(texture);
-    info_->textures.push_back(texture);
-  }
-
-  if (material->GetTextureCount(aiTextureType_SPECULAR)) {
-    QVector<Texture *> specularMaps = LoadMaterialTextures(
-        material, aiTextureType_SPECULAR, "texture_specular");
-    std::copy(specularMaps.begin(), specularMaps.end(),
-              std::back_inserter(textures));
-  } else {
-    Texture *texture = new Texture;
-    QImage data(1, 1, QImage::Format_RGB32);
-    data.fill(Qt::black);
-    texture->texture.setData(data);
-    texture->type = "texture_specular";
-    texture->path = "";
-    textures.push_back(texture);
-    info_->textures.push_back(texture);
-  }
-
-  if (material->GetTextureCount(aiTextureType_HEIGHT)) {
-    QVector<Texture *> heightMaps =
-        LoadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-    std::copy(heightMaps.begin(), heightMaps.end(),
-              std::back_inserter(textures));
-  }
+  textures << LoadMaterialTextures(material, aiTextureType_AMBIENT,
+                                   "texture_ambient");
+  textures << LoadMaterialTextures(material, aiTextureType_DIFFUSE,
+                                   "texture_diffuse");
+  textures << LoadMaterialTextures(material, aiTextureType_SPECULAR,
+                                   "texture_specular");
+  textures << LoadMaterialTextures(material, aiTextureType_HEIGHT,
+                                   "texture_normal");
 }
 
 void Model::LoadMaterial(const aiScene *scene, aiMesh *mesh,
@@ -405,39 +632,89 @@ void Model::LoadMaterial(const aiScene *scene, aiMesh *mesh,
   mat->Get(AI_MATKEY_OPACITY, material.d);
 }
 
-QVector<Texture *> Model::LoadMaterialTextures(aiMaterial *mat,
-                                               aiTextureType type,
-                                               QString typeName) {
-  QVector<Texture *> textures;
+QVector<TextureRef> Model::LoadMaterialTextures(aiMaterial *mat,
+                                                aiTextureType type,
+                                                QString typeName) {
+  QVector<TextureRef> textures;
   for (unsigned int i = 0; i < mat->GetTextureCount(type); ++i) {
     aiString str;
     mat->GetTexture(type, i, &str);
+    textures.push_back({typeName, str.C_Str()});
+  }
+  return textures;
+}
 
-    bool skip = false;
-    for (unsigned int j = 0; j < info_->textures.size(); ++j) {
-      if (std::strcmp(info_->textures[j]->path.toStdString().c_str(),
-                      str.C_Str()) == 0) {
-        textures.push_back(info_->textures[j]);
-        skip = true;
-        break;
+void Model::PrefetchImages(const aiScene *scene) {
+  const aiTextureType types[] = {aiTextureType_AMBIENT, aiTextureType_DIFFUSE,
+                                 aiTextureType_SPECULAR, aiTextureType_HEIGHT};
+  for (unsigned int i = 0; i < scene->mNumMaterials; ++i) {
+    for (auto type : types) {
+      for (auto &it : LoadMaterialTextures(scene->mMaterials[i], type, "")) {
+        m_texture_loader_.Prefetch(info_->GetDirectory().filePath(it.path));
       }
     }
-    if (!skip) {
-      Texture *texture = new Texture;
-      QImage data(info_->GetDirectory().filePath(str.C_Str()));
-      if (!data.isNull()) {
-        texture->texture.setData(data);
-        texture->type = typeName;
-        texture->path = str.C_Str();
-        textures.push_back(texture);
-        info_->textures.push_back(texture);
-      } else {
-        emit Error(QString("Не удалось успешно загружать текстуру:" +
-                           info_->GetDirectory().filePath(str.C_Str())));
-      }
+  }
+}
+
+bool Model::LoadImages(ImportProgress &progress) {
+  for (auto &mesh : m_data_) {
+    for (auto &it : mesh.textures) {
+      m_texture_loader_.Prefetch(info_->GetDirectory().filePath(it.path));
+    }
+  }
+  if (!m_texture_loader_.Wait(progress)) {
+    return false;
+  }
+
+  for (auto &it : m_texture_loader_.GetFailed()) {
+    emit Error(QString("Не удалось успешно загружать текстуру:" + it));
+  }
+  return true;
+}
+
+Mesh *Model::CreateMesh(MeshData &&data) {
+  QVector<TextureBinding> textures = LoadTextures(data.textures);
+  return new Mesh(std::move(data), std::move(textures));
+}
+
+QVector<TextureBinding> Model::LoadTextures(const QVector<TextureRef> &refs) {
+  QVector<TextureBinding> textures;
+  for (auto &it : refs) {
+    QSharedPointer<Texture> texture = LoadTexture(it);
+    if (texture) {
+      textures.push_back({it.type, texture});
+    }
+  }
+
+  auto has_type = [&textures](const QString &type) {
+    for (auto &it : textures) {
+      if (it.type == type) return true;
     }
+    return false;
+  };
+  if (!has_type("texture_ambient")) {
+    textures.push_back(
+        {"texture_ambient", TextureCache::GetDefault(Qt::white)});
+  }
+  if (!has_type("texture_diffuse")) {
+    textures.push_back(
+        {"texture_diffuse", TextureCache::GetDefault(Qt::white)});
+  }
+  if (!has_type("texture_specular")) {
+    textures.push_back(
+        {"texture_specular", TextureCache::GetDefault(Qt::black)});
   }
   return textures;
 }
 
+QSharedPointer<Texture> Model::LoadTexture(const TextureRef &ref) {
+  const QString path = info_->GetDirectory().filePath(ref.path);
+  QSharedPointer<Texture> texture = TextureCache::Find(path, TextureSampler());
+  if (!texture) {
+    texture = TextureCache::Insert(path, TextureSampler(),
+                                   m_texture_loader_.Take(path));
+  }
+  return texture;
+}
+
 }  // namespace s21
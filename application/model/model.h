@@ -3,26 +3,48 @@
 
 #include <QDir>
 #include <QVector3D>
+#include <QVector4D>
 
+#include "import_progress.h"
+#include "import_stream.h"
 #include "mesh.h"
+#include "mesh_data.h"
 #include "model_information.h"
 #include "model_settings.h"
+#include "texture_loader.h"
 
 namespace s21 {
 
 class Model : public QObject {
   Q_OBJECT
  public:
-  void DrawTexture(QOpenGLShaderProgram &shader);
-  void DrawMaterial(QOpenGLShaderProgram &shader);
-  void DrawEdge(QOpenGLShaderProgram &shader);
-  void DrawVertex(QOpenGLShaderProgram &shader);
+  const QVector<Mesh *> &GetMeshes() const;
+  // Rewrites the material blocks of the meshes after material edits.
+  void UpdateMaterials();
 
   void ChangeTexture(QImage img, QString &path);
   void DelTexture();
   void MirrorTexture();
   void SetDefaultMaterial();
 
+  qint64 SelectLods(const QMatrix4x4 &view, const QMatrix4x4 &projection,
+                    float height, float threshold);
+  void CullClusters(const QMatrix4x4 &view, const QMatrix4x4 &projection,
+                    ClusterStats &stats);
+
+  // Placements drawn with one instanced draw per range of a mesh. They are
+  // relative to the model matrix, and the first one is the model itself.
+  void SetInstances(const QVector<InstanceData> &instances);
+  // Lays count copies out on a square grid in the XZ plane, one bounding
+  // box and a quarter apart.
+  void SetInstanceGrid(int count);
+  // Color of every copy but the first, an invalid color keeps the materials.
+  void SetInstanceColor(QColor color);
+  int GetInstanceCount() const;
+  GLint GetInstanceBase() const;
+  // Moves edited placements into the instance buffer of the BufferArena.
+  void UpdateInstances();
+
   void ChangeAmbient(QColor color);
   void ChangeDiffuse(QColor color);
   void ChangeSpecular(QColor color);
@@ -32,14 +54,20 @@ class Model : public QObject {
   void ChangeRoughness(double roughness);
   void ChangeRefraction(double refract);
 
-  Mesh *GetCurrentMesh();
+  MeshPart *GetCurrentMesh();
   void ChangeCurentMesh(int i);
 
   const QMatrix4x4 GetModelMatrix() const;
   ModelSettings &GetSettings();
+  // Grows on every settings, material or texture edit.
+  quint64 GetRevision() const;
   ModelInfo GetInfo();
   QStringList GetMeshesName();
 
+  bool Import(ImportProgress &progress);
+  void SetStream(ImportStream *stream);
+  void Upload();
+
   static Model *createModel(QString path);
   void Destroy();
  signals:
@@ -52,19 +80,47 @@ class Model : public QObject {
   ModelSettings m_settings_;
 
   ModelInfo *info_;
-  Mesh *m_current_mesh_ = nullptr;
+  MeshPart *m_current_mesh_ = nullptr;
+  quint64 m_revision_ = 0;
+  // Revision whose materials are in the uniform buffers of the meshes.
+  quint64 m_material_revision_ = 0;
+  QVector<MeshPart *> m_parts_;
+  QVector<InstanceData> m_instances_{InstanceData()};
+  QVector4D m_instance_color_;
+  int m_instance_range_ = -1;
+  bool m_instances_dirty_ = true;
+  // Triangles of the selected levels of detail over all instances.
+  qint64 m_lod_triangles_ = 0;
+
+  QVector<MeshData> m_data_;
+  TextureLoader m_texture_loader_;
+  ImportStream *m_stream_ = nullptr;
 
   void TransformMatrix();
 
-  void ProcessNode(aiNode *node, const aiScene *scene);
-  Mesh *ProcessMesh(aiMesh *mesh, const aiScene *scene);
-  void LoadVertexData(aiMesh *mesh, QVector<Vertex> &vertices);
+  bool ImportFile(const QString &path, ImportProgress &progress);
+  void OptimizeMeshes();
+  void PrepareMeshes();
+  bool ImportScene(const QString &path, QVector<MeshData> &meshes,
+                   ImportProgress &progress);
+  void ProcessNode(aiNode *node, const aiScene *scene,
+                   QVector<MeshData> &meshes, ImportProgress &progress);
+  void CollectMeshes(aiNode *node, const aiScene *scene,
+                     QVector<aiMesh *> &meshes);
+  MeshData ProcessMesh(aiMesh *mesh, const aiScene *scene);
+  void LoadVertexData(aiMesh *mesh, MeshData &data);
   void LoadIndicesData(aiMesh *mesh, QVector<unsigned int> &indices);
   void LoadTextureData(const aiScene *scene, aiMesh *mesh,
-                       QVector<Texture *> &textures);
+                       QVector<TextureRef> &textures);
   void LoadMaterial(const aiScene *scene, aiMesh *mesh, Material &material);
-  QVector<Texture *> LoadMaterialTextures(aiMaterial *mat, aiTextureType type,
-                                          QString typeName);
+  QVector<TextureRef> LoadMaterialTextures(aiMaterial *mat, aiTextureType type,
+                                           QString typeName);
+
+  void PrefetchImages(const aiScene *scene);
+  bool LoadImages(ImportProgress &progress);
+  Mesh *CreateMesh(MeshData &&data);
+  QVector<TextureBinding> LoadTextures(const QVector<TextureRef> &refs);
+  QSharedPointer<Texture> LoadTexture(const TextureRef &ref);
 };
 
 }  // namespace s21
@@ -0,0 +1,45 @@
+#include "model_loader.h"
+
+namespace s21 {
+
+ModelLoader::ModelLoader(QString path, QObject *parent)
+    : QThread(parent), m_path_{path}, m_model_{Model::createModel(path)} {
+  m_model_->SetStream(&m_stream_);
+  connect(m_model_, SIGNAL(Error(QString)), this, SIGNAL(Error(QString)));
+  connect(&m_timer_, SIGNAL(timeout()), this, SLOT(UpdateProgress()));
+  connect(this, SIGNAL(finished()), &m_timer_, SLOT(stop()));
+  connect(this, SIGNAL(finished()), this, SLOT(UpdateProgress()));
+  m_timer_.start(100);
+}
+
+ModelLoader::~ModelLoader() {
+  Cancel();
+  wait();
+  if (m_model_) {
+    m_model_->Destroy();
+  }
+}
+
+void ModelLoader::Cancel() { m_progress_.Cancel(); }
+
+Model *ModelLoader::TakeModel() {
+  Model *model = nullptr;
+  if (m_success_ && !m_progress_.IsCancelled()) {
+    std::swap(model, m_model_);
+  }
+  return model;
+}
+
+QString ModelLoader::GetPath() const { return m_path_; }
+
+ImportStream &ModelLoader::GetStream() { return m_stream_; }
+
+void ModelLoader::run() { m_success_ = m_model_->Import(m_progress_); }
+
+void ModelLoader::UpdateProgress() {
+  emit Progress(m_progress_.GetBytes(), m_progress_.GetTotalBytes(),
+                m_progress_.GetMeshes(), m_progress_.GetTotalMeshes(),
+                m_stream_.GetFaces());
+}
+
+}  // namespace s21
@@ -0,0 +1,47 @@
+#ifndef MODEL_LOADER_H_
+#define MODEL_LOADER_H_
+
+#include <QThread>
+#include <QTimer>
+
+#include "import_progress.h"
+#include "import_stream.h"
+#include "model.h"
+
+namespace s21 {
+
+class ModelLoader : public QThread {
+  Q_OBJECT
+ public:
+  explicit ModelLoader(QString path, QObject *parent = nullptr);
+  ~ModelLoader();
+
+  void Cancel();
+  Model *TakeModel();
+  QString GetPath() const;
+  ImportStream &GetStream();
+
+ signals:
+  void Error(QString);
+  void Progress(qint64 bytes, qint64 total_bytes, int meshes,
+                int total_meshes, qint64 faces);
+
+ protected:
+  void run() override;
+
+ private slots:
+  void UpdateProgress();
+
+ private:
+  QString m_path_;
+  Model *m_model_;
+  bool m_success_ = false;
+
+  ImportProgress m_progress_;
+  ImportStream m_stream_;
+  QTimer m_timer_;
+};
+
+}  // namespace s21
+
+#endif  // MODEL_LOADER_H_
@@ -0,0 +1,367 @@
+#include "buffer_arena.h"
+
+#include <QMap>
+#include <QVector>
+#include <algorithm>
+
+#include "mesh.h"
+
+namespace s21 {
+
+namespace {
+
+const int kBuffers = int(ArenaBuffer::kCount);
+const int kLayouts = int(ArenaBuffer::kIndices);
+const int kInstances = int(ArenaBuffer::kInstances);
+const qint64 kMinCapacity = 1 << 22;
+const qint64 kIndexAlignment = sizeof(unsigned int);
+
+// One GL buffer with its free ranges, offset to size. Every offset and size
+// is a multiple of unit, the vertex stride or the index alignment.
+struct Pool {
+  GLuint buffer = 0;
+  qint64 unit = 1;
+  qint64 capacity = 0;
+  qint64 used = 0;
+  QMap<qint64, qint64> free;
+};
+
+struct Allocation {
+  int pool = -1;
+  qint64 offset = 0;
+  qint64 size = 0;
+};
+
+struct State {
+  QOpenGLFunctions_4_1_Core *gl = nullptr;
+  Pool pools[kBuffers];
+  GLuint vertex_arrays[kLayouts] = {};
+  GLuint instance_texture = 0;
+  QVector<Allocation> allocations;
+  QVector<int> free_handles;
+};
+
+State &GetState() {
+  static State state;
+  return state;
+}
+
+qint64 RoundUp(qint64 value, qint64 unit) {
+  return (value + unit - 1) / unit * unit;
+}
+
+bool IsValid(const State &state, int handle) {
+  return state.gl && handle >= 0 && handle < state.allocations.size() &&
+         state.allocations[handle].pool >= 0;
+}
+
+// First fit, returns -1 when no free range is large enough.
+qint64 Allocate(Pool &pool, qint64 size) {
+  for (auto it = pool.free.begin(); it != pool.free.end(); ++it) {
+    if (it.value() >= size) {
+      const qint64 offset = it.key();
+      const qint64 rest = it.value() - size;
+      pool.free.erase(it);
+      if (rest) {
+        pool.free.insert(offset + size, rest);
+      }
+      pool.used += size;
+      return offset;
+    }
+  }
+  return -1;
+}
+
+// Returns the range to the free list, merged with its free neighbours.
+void Release(Pool &pool, qint64 offset, qint64 size) {
+  pool.used -= size;
+  auto next = pool.free.lowerBound(offset);
+  if (next != pool.free.end() && offset + size == next.key()) {
+    size += next.value();
+    next = pool.free.erase(next);
+  }
+  if (next != pool.free.begin()) {
+    auto prev = next;
+    --prev;
+    if (prev.key() + prev.value() == offset) {
+      prev.value() += size;
+      return;
+    }
+  }
+  pool.free.insert(offset, size);
+}
+
+void SetVertexLayout(QOpenGLFunctions_4_1_Core &gl) {
+  const GLsizei stride = sizeof(Vertex);
+  gl.glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride,
+                           reinterpret_cast<const void *>(0));
+  gl.glVertexAttribPointer(
+      1, 3, GL_FLOAT, GL_FALSE, stride,
+      reinterpret_cast<const void *>(offsetof(Vertex, Normal)));
+  gl.glVertexAttribPointer(
+      2, 2, GL_FLOAT, GL_FALSE, stride,
+      reinterpret_cast<const void *>(offsetof(Vertex, TexCoords)));
+  gl.glVertexAttribPointer(
+      3, 3, GL_FLOAT, GL_FALSE, stride,
+      reinterpret_cast<const void *>(offsetof(Vertex, Tangent)));
+  gl.glVertexAttribPointer(
+      4, 3, GL_FLOAT, GL_FALSE, stride,
+      reinterpret_cast<const void *>(offsetof(Vertex, Bitangent)));
+  for (GLuint i = 0; i < 5; ++i) {
+    gl.glEnableVertexAttribArray(i);
+  }
+}
+
+void SetCompactLayout(QOpenGLFunctions_4_1_Core &gl) {
+  const GLsizei stride = sizeof(CompactVertex);
+  gl.glVertexAttribPointer(
+      0, 3, GL_UNSIGNED_SHORT, GL_FALSE, stride,
+      reinterpret_cast<const void *>(offsetof(CompactVertex, Position)));
+  gl.glVertexAttribPointer(
+      1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+      reinterpret_cast<const void *>(offsetof(CompactVertex, Normal)));
+  gl.glVertexAttribPointer(
+      2, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+      reinterpret_cast<const void *>(offsetof(CompactVertex, TexCoords)));
+  gl.glVertexAttribPointer(
+      3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+      reinterpret_cast<const void *>(offsetof(CompactVertex, Tangent)));
+  for (GLuint i = 0; i < 4; ++i) {
+    gl.glEnableVertexAttribArray(i);
+  }
+}
+
+// Points the vertex arrays at the current buffers, needed whenever a
+// buffer is replaced.
+void SetupVertexArrays(State &state) {
+  QOpenGLFunctions_4_1_Core &gl = *state.gl;
+  const GLuint indices = state.pools[int(ArenaBuffer::kIndices)].buffer;
+  for (int i = 0; i < kLayouts; ++i) {
+    gl.glBindVertexArray(state.vertex_arrays[i]);
+    gl.glBindBuffer(GL_ARRAY_BUFFER, state.pools[i].buffer);
+    if (ArenaBuffer(i) == ArenaBuffer::kCompactVertices) {
+      SetCompactLayout(gl);
+    } else {
+      SetVertexLayout(gl);
+    }
+    gl.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices);
+  }
+  gl.glBindVertexArray(0);
+  gl.glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void AttachInstanceTexture(State &state) {
+  QOpenGLFunctions_4_1_Core &gl = *state.gl;
+  gl.glBindTexture(GL_TEXTURE_BUFFER, state.instance_texture);
+  gl.glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F,
+                 state.pools[kInstances].buffer);
+  gl.glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+// Moves the pool into a new buffer of the given capacity. Growing keeps
+// every offset, packing moves the allocations to the start in offset order.
+void Reallocate(State &state, int index, qint64 capacity, bool pack) {
+  QOpenGLFunctions_4_1_Core &gl = *state.gl;
+  Pool &pool = state.pools[index];
+
+  GLuint buffer = 0;
+  gl.glGenBuffers(1, &buffer);
+  gl.glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+  gl.glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_STATIC_DRAW);
+  gl.glBindBuffer(GL_COPY_READ_BUFFER, pool.buffer);
+
+  if (pack) {
+    QVector<Allocation *> live;
+    for (Allocation &it : state.allocations) {
+      if (it.pool == index) live.push_back(&it);
+    }
+    std::sort(live.begin(), live.end(),
+              [](const Allocation *a, const Allocation *b) {
+                return a->offset < b->offset;
+              });
+    qint64 end = 0;
+    for (Allocation *it : live) {
+      gl.glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                             it->offset, end, it->size);
+      it->offset = end;
+      end += it->size;
+    }
+    pool.free.clear();
+    if (end < capacity) {
+      pool.free.insert(end, capacity - end);
+    }
+  } else {
+    if (pool.used) {
+      gl.glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                             pool.capacity);
+    }
+    const qint64 added = capacity - pool.capacity;
+    pool.used += added;
+    Release(pool, pool.capacity, added);
+  }
+
+  gl.glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  gl.glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  gl.glDeleteBuffers(1, &pool.buffer);
+  pool.buffer = buffer;
+  pool.capacity = capacity;
+  // Instances may grow while a frame is drawn, so they leave the vertex
+  // arrays alone.
+  if (index == kInstances) {
+    AttachInstanceTexture(state);
+  } else {
+    SetupVertexArrays(state);
+  }
+}
+
+}  // namespace
+
+void BufferArena::Create(QOpenGLFunctions_4_1_Core &gl) {
+  State &state = GetState();
+  if (state.gl) return;
+  state.gl = &gl;
+
+  const qint64 units[kBuffers] = {sizeof(Vertex), sizeof(CompactVertex),
+                                  kIndexAlignment, sizeof(InstanceData)};
+  for (int i = 0; i < kBuffers; ++i) {
+    Pool &pool = state.pools[i];
+    pool.unit = units[i];
+    pool.capacity = RoundUp(kMinCapacity, pool.unit);
+    pool.free.insert(0, pool.capacity);
+    gl.glGenBuffers(1, &pool.buffer);
+    gl.glBindBuffer(GL_COPY_WRITE_BUFFER, pool.buffer);
+    gl.glBufferData(GL_COPY_WRITE_BUFFER, pool.capacity, nullptr,
+                    GL_STATIC_DRAW);
+  }
+  gl.glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  gl.glGenVertexArrays(kLayouts, state.vertex_arrays);
+  SetupVertexArrays(state);
+  gl.glGenTextures(1, &state.instance_texture);
+  AttachInstanceTexture(state);
+}
+
+void BufferArena::Destroy() {
+  State &state = GetState();
+  if (!state.gl) return;
+  state.gl->glDeleteVertexArrays(kLayouts, state.vertex_arrays);
+  state.gl->glDeleteTextures(1, &state.instance_texture);
+  for (Pool &it : state.pools) {
+    state.gl->glDeleteBuffers(1, &it.buffer);
+  }
+  state = State();
+}
+
+int BufferArena::Add(ArenaBuffer buffer, const void *data, qint64 bytes) {
+  State &state = GetState();
+  if (!state.gl) return -1;
+  const int index = int(buffer);
+  Pool &pool = state.pools[index];
+
+  const qint64 size = RoundUp(std::max(bytes, qint64(1)), pool.unit);
+  qint64 offset = Allocate(pool, size);
+  if (offset < 0) {
+    const qint64 capacity =
+        std::max(2 * pool.capacity, pool.capacity + size);
+    Reallocate(state, index, RoundUp(capacity, pool.unit), false);
+    offset = Allocate(pool, size);
+  }
+  state.gl->glBindBuffer(GL_COPY_WRITE_BUFFER, pool.buffer);
+  state.gl->glBufferSubData(GL_COPY_WRITE_BUFFER, offset, bytes, data);
+  state.gl->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  int handle = state.allocations.size();
+  if (state.free_handles.isEmpty()) {
+    state.allocations.push_back(Allocation());
+  } else {
+    handle = state.free_handles.takeLast();
+  }
+  state.allocations[handle] = {index, offset, size};
+  return handle;
+}
+
+void BufferArena::Remove(int handle) {
+  State &state = GetState();
+  if (!IsValid(state, handle)) return;
+  Allocation &allocation = state.allocations[handle];
+  Release(state.pools[allocation.pool], allocation.offset, allocation.size);
+  allocation = Allocation();
+  state.free_handles.push_back(handle);
+}
+
+bool BufferArena::Read(int handle, void *data, qint64 bytes) {
+  State &state = GetState();
+  if (!IsValid(state, handle)) return false;
+  const Allocation &allocation = state.allocations[handle];
+  if (bytes > allocation.size) return false;
+  state.gl->glBindBuffer(GL_COPY_READ_BUFFER,
+                         state.pools[allocation.pool].buffer);
+  state.gl->glGetBufferSubData(GL_COPY_READ_BUFFER, allocation.offset, bytes,
+                               data);
+  state.gl->glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  return true;
+}
+
+GLint BufferArena::GetBaseVertex(int handle) {
+  const State &state = GetState();
+  if (!IsValid(state, handle)) return 0;
+  const Allocation &allocation = state.allocations[handle];
+  return allocation.offset / state.pools[allocation.pool].unit;
+}
+
+GLint BufferArena::GetBaseInstance(int handle) {
+  return GetBaseVertex(handle);
+}
+
+qintptr BufferArena::GetOffset(int handle) {
+  const State &state = GetState();
+  return IsValid(state, handle) ? state.allocations[handle].offset : 0;
+}
+
+GLuint BufferArena::GetVertexArray(ArenaBuffer buffer) {
+  const int index = int(buffer);
+  return index < kLayouts ? GetState().vertex_arrays[index] : 0;
+}
+
+GLuint BufferArena::GetInstanceTexture() {
+  return GetState().instance_texture;
+}
+
+ArenaStats BufferArena::GetStats(ArenaBuffer buffer) {
+  const State &state = GetState();
+  const int index = int(buffer);
+  const Pool &pool = state.pools[index];
+  ArenaStats stats;
+  stats.capacity = pool.capacity;
+  stats.used = pool.used;
+  for (auto it = pool.free.begin(); it != pool.free.end(); ++it) {
+    stats.largest_free = std::max(stats.largest_free, it.value());
+    if (it.key() + it.value() != pool.capacity) ++stats.holes;
+  }
+  for (const Allocation &it : state.allocations) {
+    if (it.pool == index) ++stats.allocations;
+  }
+  return stats;
+}
+
+bool BufferArena::IsFragmented() {
+  for (int i = 0; i < kBuffers; ++i) {
+    const ArenaStats stats = GetStats(ArenaBuffer(i));
+    if (stats.capacity - stats.used > stats.capacity / 4 &&
+        stats.GetFragmentation() > 0.5) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void BufferArena::Defragment() {
+  State &state = GetState();
+  if (!state.gl) return;
+  for (int i = 0; i < kBuffers; ++i) {
+    if (GetStats(ArenaBuffer(i)).holes) {
+      Reallocate(state, i, state.pools[i].capacity, true);
+    }
+  }
+}
+
+}  // namespace s21
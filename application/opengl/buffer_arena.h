@@ -0,0 +1,71 @@
+#ifndef BUFFER_ARENA_H_
+#define BUFFER_ARENA_H_
+
+#include <QOpenGLFunctions_4_1_Core>
+
+namespace s21 {
+
+// The buffers of the arena: one per vertex layout, one for the indices of
+// every mesh and one for the model instances.
+enum class ArenaBuffer {
+  kVertices = 0,
+  kCompactVertices,
+  kIndices,
+  kInstances,
+  kCount
+};
+
+struct ArenaStats {
+  qint64 capacity = 0;
+  qint64 used = 0;
+  qint64 largest_free = 0;
+  int allocations = 0;
+  int holes = 0;
+
+  // Share of the free space that lies outside the largest free block.
+  double GetFragmentation() const {
+    const qint64 free = capacity - used;
+    return free ? 1.0 - double(largest_free) / free : 0.0;
+  }
+};
+
+// Process-wide GPU memory for mesh geometry. Each buffer is one large GL
+// buffer sub-allocated through a free list ordered by offset, and grows by
+// doubling. Every vertex layout has a single VAO over its buffer and the
+// index buffer, so meshes draw with glDrawElementsBaseVertex. Allocations
+// are addressed by handles that stay valid across growth and
+// defragmentation. Must be used from the GL thread with a current context.
+class BufferArena {
+ public:
+  static void Create(QOpenGLFunctions_4_1_Core &gl);
+  static void Destroy();
+
+  // Copies the data into the buffer and returns the allocation handle.
+  static int Add(ArenaBuffer buffer, const void *data, qint64 bytes);
+  static void Remove(int handle);
+  // Reads the first bytes of an allocation back into data. Stalls until
+  // the GPU is done with the buffer, so it is meant for rare checks only.
+  static bool Read(int handle, void *data, qint64 bytes);
+
+  // First vertex of an allocation in a vertex buffer.
+  static GLint GetBaseVertex(int handle);
+  // First instance of an allocation in the instance buffer.
+  static GLint GetBaseInstance(int handle);
+  // Byte offset of an allocation in its buffer.
+  static qintptr GetOffset(int handle);
+  static GLuint GetVertexArray(ArenaBuffer buffer);
+  // RGBA32F buffer texture over the instance buffer, GL 4.1 shaders have
+  // no storage buffers to read it through.
+  static GLuint GetInstanceTexture();
+
+  static ArenaStats GetStats(ArenaBuffer buffer);
+  // True once some buffer has much of its free space split into holes.
+  static bool IsFragmented();
+  // Packs the allocations of every buffer at its start, leaving a single
+  // free block at the end.
+  static void Defragment();
+};
+
+}  // namespace s21
+
+#endif  // BUFFER_ARENA_H_
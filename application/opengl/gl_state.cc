@@ -0,0 +1,82 @@
+#include "gl_state.h"
+
+#include <algorithm>
+
+namespace s21 {
+
+namespace {
+
+// Never a valid name or mode, so the first call after a reset is always made.
+const GLuint kUnknown = ~GLuint(0);
+
+}  // namespace
+
+GlState::GlState(QOpenGLFunctions_4_1_Core &gl) : m_gl_{gl} { Reset(); }
+
+QOpenGLFunctions_4_1_Core &GlState::Functions() { return m_gl_; }
+
+void GlState::Reset() {
+  m_stats_ = GlStateStats();
+  m_vao_ = kUnknown;
+  m_polygon_mode_ = kUnknown;
+  m_active_unit_ = -1;
+  std::fill(m_textures_, m_textures_ + kTextureUnits, kUnknown);
+  std::fill(m_ranges_, m_ranges_ + kUniformBindings,
+            UniformRange{kUnknown, 0, 0});
+}
+
+GlStateStats GlState::GetStats() const { return m_stats_; }
+
+template <class T>
+bool GlState::Change(T &current, const T &value) {
+  if (current == value) {
+    ++m_stats_.avoided;
+    return false;
+  }
+  current = value;
+  ++m_stats_.changes;
+  return true;
+}
+
+void GlState::BindVertexArray(GLuint vao) {
+  if (Change(m_vao_, vao)) {
+    m_gl_.glBindVertexArray(vao);
+  }
+}
+
+void GlState::PolygonMode(GLenum mode) {
+  if (Change(m_polygon_mode_, mode)) {
+    m_gl_.glPolygonMode(GL_FRONT_AND_BACK, mode);
+  }
+}
+
+void GlState::BindTexture(int unit, GLuint texture, GLenum target) {
+  if (unit < 0 || unit >= kTextureUnits) {
+    m_gl_.glActiveTexture(GL_TEXTURE0 + unit);
+    m_gl_.glBindTexture(target, texture);
+    m_active_unit_ = -1;
+    return;
+  }
+  if (m_textures_[unit] == texture) {
+    ++m_stats_.avoided;
+    return;
+  }
+  if (Change(m_active_unit_, unit)) {
+    m_gl_.glActiveTexture(GL_TEXTURE0 + unit);
+  }
+  Change(m_textures_[unit], texture);
+  m_gl_.glBindTexture(target, texture);
+}
+
+void GlState::BindUniformRange(int index, GLuint buffer, GLintptr offset,
+                               GLsizeiptr size) {
+  if (index < 0 || index >= kUniformBindings) {
+    m_gl_.glBindBufferRange(GL_UNIFORM_BUFFER, index, buffer, offset, size);
+    return;
+  }
+  if (Change(m_ranges_[index], UniformRange{buffer, offset, size})) {
+    m_gl_.glBindBufferRange(GL_UNIFORM_BUFFER, index, buffer, offset, size);
+  }
+}
+
+}  // namespace s21
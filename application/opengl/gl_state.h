@@ -0,0 +1,68 @@
+#ifndef GL_STATE_H_
+#define GL_STATE_H_
+
+#include <QOpenGLFunctions_4_1_Core>
+
+namespace s21 {
+
+// State changes sent to the driver and the ones dropped because the object
+// or mode was already current.
+struct GlStateStats {
+  qint64 changes = 0;
+  qint64 avoided = 0;
+};
+
+// Remembers the binds and modes set through it and drops the calls that
+// would not change anything. Qt objects and the scene bind on their own
+// behind its back, so the state is forgotten at the start of every frame.
+class GlState {
+ public:
+  static const int kTextureUnits = 32;
+  static const int kUniformBindings = 8;
+  // Unit kept for the buffer texture of the model instances.
+  static const int kInstanceUnit = kTextureUnits - 1;
+
+  explicit GlState(QOpenGLFunctions_4_1_Core &gl);
+
+  QOpenGLFunctions_4_1_Core &Functions();
+
+  // Forgets the tracked state and clears the counters.
+  void Reset();
+  GlStateStats GetStats() const;
+
+  void BindVertexArray(GLuint vao);
+  void PolygonMode(GLenum mode);
+  // A unit is expected to stick to one target.
+  void BindTexture(int unit, GLuint texture, GLenum target = GL_TEXTURE_2D);
+  void BindUniformRange(int index, GLuint buffer, GLintptr offset,
+                        GLsizeiptr size);
+
+ private:
+  struct UniformRange {
+    GLuint buffer;
+    GLintptr offset;
+    GLsizeiptr size;
+
+    bool operator==(const UniformRange &other) const {
+      return buffer == other.buffer && offset == other.offset &&
+             size == other.size;
+    }
+  };
+
+  // Stores the value and returns true when the call has to be made.
+  template <class T>
+  bool Change(T &current, const T &value);
+
+  QOpenGLFunctions_4_1_Core &m_gl_;
+  GlStateStats m_stats_;
+
+  GLuint m_vao_;
+  GLenum m_polygon_mode_;
+  int m_active_unit_;
+  GLuint m_textures_[kTextureUnits];
+  UniformRange m_ranges_[kUniformBindings];
+};
+
+}  // namespace s21
+
+#endif  // GL_STATE_H_
@@ -0,0 +1,162 @@
+#include "multi_draw.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QSurfaceFormat>
+#include <algorithm>
+
+#include "buffer_arena.h"
+
+namespace s21 {
+
+namespace {
+
+const ArenaBuffer kLayouts[] = {ArenaBuffer::kVertices,
+                                ArenaBuffer::kCompactVertices};
+
+QByteArray MaterialState(const MaterialBlock &block) {
+  return QByteArray(reinterpret_cast<const char *>(&block), sizeof(block));
+}
+
+}  // namespace
+
+bool MultiDraw::Create(GlState &state, QOpenGLContext &context) {
+  if (context.format().version() < qMakePair(4, 3)) return false;
+  m_multi_draw_elements_indirect_ =
+      reinterpret_cast<MultiDrawElementsIndirect>(
+          context.getProcAddress("glMultiDrawElementsIndirect"));
+  if (!m_multi_draw_elements_indirect_) return false;
+
+  QOpenGLFunctions_4_1_Core &gl = state.Functions();
+  gl.glGenBuffers(1, &m_draw_ids_);
+  gl.glGenBuffers(1, &m_draws_);
+  gl.glGenBuffers(1, &m_materials_);
+  gl.glGenBuffers(1, &m_commands_);
+  // The id advances once per instance. The attribute stays disabled outside
+  // Draw, where the other programs draw instances past the ids.
+  gl.glBindBuffer(GL_ARRAY_BUFFER, m_draw_ids_);
+  for (ArenaBuffer layout : kLayouts) {
+    state.BindVertexArray(BufferArena::GetVertexArray(layout));
+    gl.glVertexAttribIPointer(kDrawAttribute, 1, GL_UNSIGNED_INT, 0,
+                              nullptr);
+    gl.glVertexAttribDivisor(kDrawAttribute, 1);
+  }
+  gl.glBindBuffer(GL_ARRAY_BUFFER, 0);
+  return true;
+}
+
+void MultiDraw::Destroy(QOpenGLFunctions_4_1_Core &gl) {
+  if (!IsEnabled()) return;
+  const GLuint buffers[] = {m_draw_ids_, m_draws_, m_materials_, m_commands_};
+  gl.glDeleteBuffers(4, buffers);
+  m_multi_draw_elements_indirect_ = nullptr;
+}
+
+bool MultiDraw::IsEnabled() const { return m_multi_draw_elements_indirect_; }
+
+void MultiDraw::Update(GlState &state, const QVector<RenderItem> &items,
+                       const QMatrix4x4 &scene) {
+  if (!IsEnabled()) return;
+
+  m_draw_id_data_.clear();
+  m_first_ids_.clear();
+  m_draw_data_.clear();
+  m_material_data_.clear();
+  QHash<QByteArray, quint32> materials;
+  for (const RenderItem &it : items) {
+    const MaterialBlock block(it.mesh->GetParts()[it.begin].GetMaterial());
+    auto material = materials.find(MaterialState(block));
+    if (material == materials.end()) {
+      material = materials.insert(MaterialState(block),
+                                  quint32(m_material_data_.size()));
+      m_material_data_.push_back(block);
+    }
+
+    DrawData draw;
+    const QMatrix4x4 model = scene * it.model->GetModelMatrix();
+    std::copy(model.constData(), model.constData() + 16, draw.model);
+    draw.position_offset = it.mesh->GetPositionOffset();
+    draw.material = material.value();
+    draw.position_scale = it.mesh->GetPositionScale();
+    draw.instance_base = it.model->GetInstanceBase();
+    m_draw_data_.push_back(draw);
+
+    m_first_ids_.push_back(m_draw_id_data_.size());
+    m_draw_id_data_.insert(m_draw_id_data_.size(),
+                           it.model->GetInstanceCount(),
+                           quint32(m_draw_data_.size() - 1));
+  }
+
+  QOpenGLFunctions_4_1_Core &gl = state.Functions();
+  gl.glBindBuffer(GL_ARRAY_BUFFER, m_draw_ids_);
+  gl.glBufferData(GL_ARRAY_BUFFER, m_draw_id_data_.size() * sizeof(quint32),
+                  m_draw_id_data_.constData(), GL_DYNAMIC_DRAW);
+  gl.glBindBuffer(GL_ARRAY_BUFFER, 0);
+  gl.glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_draws_);
+  gl.glBufferData(GL_SHADER_STORAGE_BUFFER,
+                  m_draw_data_.size() * sizeof(DrawData),
+                  m_draw_data_.constData(), GL_DYNAMIC_DRAW);
+  gl.glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_materials_);
+  gl.glBufferData(GL_SHADER_STORAGE_BUFFER,
+                  m_material_data_.size() * sizeof(MaterialBlock),
+                  m_material_data_.constData(), GL_DYNAMIC_DRAW);
+  gl.glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void MultiDraw::Draw(GlState &state, const QVector<RenderItem> &items,
+                     int begin, int end) {
+  if (!IsEnabled() || begin >= end) return;
+
+  // Level of detail and culling change the ranges every frame, so the
+  // commands are rebuilt while the draw data stays.
+  m_command_data_.clear();
+  m_batches_.clear();
+  for (int i = begin; i < end; ++i) {
+    const RenderItem &it = items[i];
+    const bool wireframe = it.model->GetSettings().GetTextureSettings().type ==
+                           TextureType::kWireFrame;
+    const Batch batch{GLenum(wireframe ? GL_LINE : GL_FILL),
+                      it.mesh->GetLayout(), it.mesh->GetIndexType(),
+                      int(m_command_data_.size()), 0};
+    if (m_batches_.isEmpty() ||
+        m_batches_.back().polygon_mode != batch.polygon_mode ||
+        m_batches_.back().layout != batch.layout ||
+        m_batches_.back().index_type != batch.index_type) {
+      m_batches_.push_back(batch);
+    }
+    it.mesh->AppendCommands(it.begin, it.end, m_first_ids_[i],
+                            it.model->GetInstanceCount(), m_command_data_);
+    m_batches_.back().count =
+        m_command_data_.size() - m_batches_.back().first;
+  }
+
+  QOpenGLFunctions_4_1_Core &gl = state.Functions();
+  gl.glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commands_);
+  gl.glBufferData(GL_DRAW_INDIRECT_BUFFER,
+                  m_command_data_.size() * sizeof(DrawCommand),
+                  m_command_data_.constData(), GL_STREAM_DRAW);
+  gl.glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kDrawBinding, m_draws_);
+  gl.glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kMaterialBinding,
+                      m_materials_);
+  for (ArenaBuffer layout : kLayouts) {
+    state.BindVertexArray(BufferArena::GetVertexArray(layout));
+    gl.glEnableVertexAttribArray(kDrawAttribute);
+  }
+
+  for (const Batch &it : m_batches_) {
+    if (!it.count) continue;
+    state.PolygonMode(it.polygon_mode);
+    state.BindVertexArray(BufferArena::GetVertexArray(it.layout));
+    m_multi_draw_elements_indirect_(
+        GL_TRIANGLES, it.index_type,
+        reinterpret_cast<const void *>(it.first * sizeof(DrawCommand)),
+        it.count, 0);
+  }
+  for (ArenaBuffer layout : kLayouts) {
+    state.BindVertexArray(BufferArena::GetVertexArray(layout));
+    gl.glDisableVertexAttribArray(kDrawAttribute);
+  }
+  gl.glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+}  // namespace s21
@@ -0,0 +1,87 @@
+#ifndef MULTI_DRAW_H_
+#define MULTI_DRAW_H_
+
+#include <QMatrix4x4>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QVector3D>
+#include <QVector>
+
+#include "gl_state.h"
+#include "mesh.h"
+#include "render_queue.h"
+
+namespace s21 {
+
+// Everything a draw of the multi-draw shaders reads from the draw buffer,
+// in std430.
+struct DrawData {
+  float model[16];
+  QVector3D position_offset;
+  quint32 material;
+  QVector3D position_scale;
+  qint32 instance_base;
+};
+static_assert(sizeof(DrawData) == 96, "DrawData does not match");
+
+// Submits runs of render items with one glMultiDrawElementsIndirect per
+// polygon mode, vertex layout and index type. Needs GL 4.3 for the indirect
+// multi-draw and the storage buffers, so contexts below it keep drawing
+// every item on its own.
+//
+// A command draws the instances of its model from the first draw id slot of
+// its item. The per-instance draw id attribute repeats the index of the
+// item's DrawData once per instance, and gl_InstanceID picks the placement.
+// Materials are deduplicated into their own storage buffer.
+class MultiDraw {
+ public:
+  // Storage buffer bindings used by the shaders compiled with MULTI_DRAW.
+  static const int kDrawBinding = 0;
+  static const int kMaterialBinding = 1;
+  // Vertex attribute that holds the draw id in the arena vertex arrays.
+  static const int kDrawAttribute = 5;
+
+  // Returns false and stays disabled when the context lacks GL 4.3.
+  bool Create(GlState &state, QOpenGLContext &context);
+  void Destroy(QOpenGLFunctions_4_1_Core &gl);
+  bool IsEnabled() const;
+
+  // Rewrites the draw data of every item, needed whenever the queue is
+  // rebuilt. scene is applied on top of the model matrices.
+  void Update(GlState &state, const QVector<RenderItem> &items,
+              const QMatrix4x4 &scene);
+  // Draws the items [begin, end) with the bound program.
+  void Draw(GlState &state, const QVector<RenderItem> &items, int begin,
+            int end);
+
+ private:
+  typedef void(QOPENGLF_APIENTRYP MultiDrawElementsIndirect)(
+      GLenum mode, GLenum type, const void *indirect, GLsizei drawcount,
+      GLsizei stride);
+
+  struct Batch {
+    GLenum polygon_mode;
+    ArenaBuffer layout;
+    GLenum index_type;
+    int first;
+    int count;
+  };
+
+  MultiDrawElementsIndirect m_multi_draw_elements_indirect_ = nullptr;
+  GLuint m_draw_ids_ = 0;
+  GLuint m_draws_ = 0;
+  GLuint m_materials_ = 0;
+  GLuint m_commands_ = 0;
+
+  QVector<quint32> m_draw_id_data_;
+  // First draw id slot of every item.
+  QVector<int> m_first_ids_;
+  QVector<DrawData> m_draw_data_;
+  QVector<MaterialBlock> m_material_data_;
+  QVector<DrawCommand> m_command_data_;
+  QVector<Batch> m_batches_;
+};
+
+}  // namespace s21
+
+#endif  // MULTI_DRAW_H_
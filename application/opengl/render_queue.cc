@@ -0,0 +1,147 @@
+#include "render_queue.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace s21 {
+
+namespace {
+
+// Key fields from the least significant bit up.
+const int kDepthShift = 0;
+const int kMaterialShift = 20;
+const int kTextureShift = 40;
+const int kModeShift = 60;
+const int kProgramShift = 61;
+const quint64 kFieldMask = (quint64(1) << 20) - 1;
+
+const int kDigitBits = 8;
+const int kBuckets = 1 << kDigitBits;
+
+bool IsDrawn(RenderPass pass, ModelSettings &settings) {
+  switch (pass) {
+    case RenderPass::kEdge:
+      return settings.GetEdgeSettings().type != EdgeType::kNo;
+    case RenderPass::kVertex:
+      return settings.GetVertexSettings().type != VertexType::kNo;
+    default:
+      return settings.GetTextureSettings().type != TextureType::kNo;
+  }
+}
+
+// Small ids for equal state, so that it sorts together.
+quint64 StateId(QHash<QByteArray, quint64> &ids, const QByteArray &state) {
+  auto it = ids.find(state);
+  if (it == ids.end()) {
+    it = ids.insert(state, std::min(quint64(ids.size()), kFieldMask));
+  }
+  return it.value();
+}
+
+QByteArray TextureState(const MeshPart &part) {
+  QByteArray state;
+  for (const TextureBinding &it : part.GetTextures()) {
+    const quintptr texture = quintptr(it.texture.data());
+    state.append(reinterpret_cast<const char *>(&texture), sizeof(texture));
+  }
+  return state;
+}
+
+QByteArray MaterialState(MeshPart &part) {
+  const MaterialBlock block(part.GetMaterial());
+  return QByteArray(reinterpret_cast<const char *>(&block), sizeof(block));
+}
+
+}  // namespace
+
+void RenderQueue::Build(RenderPass pass, const QVector<Model *> &models,
+                        const QMatrix4x4 &view) {
+  m_items_.clear();
+  QVector<float> depths;
+  QHash<QByteArray, quint64> textures;
+  QHash<QByteArray, quint64> materials;
+  float nearest = INFINITY;
+  float farthest = -INFINITY;
+
+  for (int i = 0; i < models.size(); ++i) {
+    Model *model = models[i];
+    ModelSettings &settings = model->GetSettings();
+    if (!IsDrawn(pass, settings)) continue;
+
+    quint64 program = kProgramMaterial;
+    quint64 mode = 0;
+    if (pass == RenderPass::kSurface) {
+      if (settings.GetSurfaceSettings() == SurfaceType::kTexture) {
+        program = kProgramTexture;
+      }
+      mode = settings.GetTextureSettings().type == TextureType::kWireFrame;
+    }
+    const QMatrix4x4 model_view = view * model->GetModelMatrix();
+
+    for (Mesh *mesh : model->GetMeshes()) {
+      const float depth = -model_view.map(mesh->GetCenter()).z();
+      nearest = std::min(nearest, depth);
+      farthest = std::max(farthest, depth);
+
+      QVector<int> runs{0, int(mesh->GetParts().size())};
+      if (pass == RenderPass::kSurface) {
+        runs = mesh->GetRuns();
+      }
+      for (int j = 0; j + 1 < runs.size(); ++j) {
+        MeshPart &part = mesh->GetParts()[runs[j]];
+        quint64 key = program << kProgramShift | mode << kModeShift;
+        if (pass != RenderPass::kSurface) {
+          // Edges and points take their style from the model, so the model
+          // stands in for the material.
+          key |= std::min(quint64(i), kFieldMask) << kMaterialShift;
+        } else {
+          if (program == kProgramTexture) {
+            key |= StateId(textures, TextureState(part)) << kTextureShift;
+          }
+          key |= StateId(materials, MaterialState(part)) << kMaterialShift;
+        }
+        m_items_.push_back({key, model, mesh, runs[j], runs[j + 1]});
+        depths.push_back(depth);
+      }
+    }
+  }
+
+  const float range = farthest > nearest ? farthest - nearest : 1.0f;
+  for (int i = 0; i < m_items_.size(); ++i) {
+    const float depth = (depths[i] - nearest) / range;
+    m_items_[i].key |= quint64(depth * kFieldMask) << kDepthShift;
+  }
+  Sort();
+}
+
+const QVector<RenderItem> &RenderQueue::GetItems() const { return m_items_; }
+
+int RenderQueue::GetProgram(quint64 key) { return key >> kProgramShift; }
+
+void RenderQueue::Sort() {
+  const int size = m_items_.size();
+  m_scratch_.resize(size);
+  for (int shift = 0; shift < 64; shift += kDigitBits) {
+    int offsets[kBuckets] = {};
+    for (const RenderItem &it : m_items_) {
+      ++offsets[(it.key >> shift) & (kBuckets - 1)];
+    }
+    // A digit shared by every key leaves the order as it is.
+    if (std::find(offsets, offsets + kBuckets, size) != offsets + kBuckets) {
+      continue;
+    }
+    int first = 0;
+    for (int &it : offsets) {
+      first += std::exchange(it, first);
+    }
+    for (const RenderItem &it : m_items_) {
+      m_scratch_[offsets[(it.key >> shift) & (kBuckets - 1)]++] = it;
+    }
+    m_items_.swap(m_scratch_);
+  }
+}
+
+}  // namespace s21
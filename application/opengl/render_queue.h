@@ -0,0 +1,52 @@
+#ifndef RENDER_QUEUE_H_
+#define RENDER_QUEUE_H_
+
+#include <QMatrix4x4>
+#include <QVector>
+
+#include "model.h"
+
+namespace s21 {
+
+// Passes drawn through a queue. The surface pass holds both the material
+// and the texture program.
+enum class RenderPass { kSurface = 0, kEdge, kVertex };
+
+// One draw of a pass: the run of parts [begin, end) of a mesh.
+struct RenderItem {
+  quint64 key = 0;
+  Model *model = nullptr;
+  Mesh *mesh = nullptr;
+  int begin = 0;
+  int end = 0;
+};
+
+// The draws of a pass ordered by a packed key, from the most significant
+// field: program, polygon mode, texture set, material, depth. Neighbouring
+// draws then share as much state as possible and equal state is drawn
+// front to back.
+class RenderQueue {
+ public:
+  static const int kProgramMaterial = 0;
+  static const int kProgramTexture = 1;
+
+  // Collects and sorts the draws of the models. Depths are taken with the
+  // given view, the queue is only meant to be rebuilt when the scene
+  // changes.
+  void Build(RenderPass pass, const QVector<Model *> &models,
+             const QMatrix4x4 &view);
+  const QVector<RenderItem> &GetItems() const;
+
+  static int GetProgram(quint64 key);
+
+ private:
+  // Least significant digit first radix sort on the key.
+  void Sort();
+
+  QVector<RenderItem> m_items_;
+  QVector<RenderItem> m_scratch_;
+};
+
+}  // namespace s21
+
+#endif  // RENDER_QUEUE_H_
@@ -0,0 +1,93 @@
+#include "shader_program.h"
+
+#include <cstring>
+
+namespace s21 {
+
+namespace {
+
+const char *const kUniformNames[] = {
+    "projection",
+    "view",
+    "model",
+    "viewPos",
+    "positionOffset",
+    "positionScale",
+    "packedTangents",
+    "skybox",
+    "maps.ambient",
+    "maps.diffuse",
+    "maps.specular",
+    "maps.normal",
+    "maps.height",
+    "u_thickness",
+    "u_viewportInvSize",
+    "PointColor",
+    "RoundPoint",
+    "PointSize",
+    "instances",
+    "instanceBase",
+};
+static_assert(sizeof(kUniformNames) / sizeof(kUniformNames[0]) ==
+                  int(Uniform::kCount),
+              "every uniform needs a name");
+
+}  // namespace
+
+void ShaderProgram::ResolveUniforms() {
+  for (int i = 0; i < int(Uniform::kCount); ++i) {
+    m_slots_[i].location = uniformLocation(kUniformNames[i]);
+    m_slots_[i].known = false;
+  }
+}
+
+int ShaderProgram::Update(Uniform uniform, const void *value, int bytes) {
+  Slot &slot = m_slots_[int(uniform)];
+  if (slot.location < 0 ||
+      (slot.known && !std::memcmp(slot.value, value, bytes))) {
+    return -1;
+  }
+  std::memcpy(slot.value, value, bytes);
+  slot.known = true;
+  return slot.location;
+}
+
+void ShaderProgram::SetUniform(Uniform uniform, float value) {
+  const int location = Update(uniform, &value, sizeof(value));
+  if (location >= 0) setUniformValue(location, value);
+}
+
+void ShaderProgram::SetUniform(Uniform uniform, int value) {
+  const int location = Update(uniform, &value, sizeof(value));
+  if (location >= 0) setUniformValue(location, value);
+}
+
+void ShaderProgram::SetUniform(Uniform uniform, bool value) {
+  SetUniform(uniform, int(value));
+}
+
+void ShaderProgram::SetUniform(Uniform uniform, const QVector2D &value) {
+  const float data[2] = {value.x(), value.y()};
+  const int location = Update(uniform, data, sizeof(data));
+  if (location >= 0) setUniformValue(location, value);
+}
+
+void ShaderProgram::SetUniform(Uniform uniform, const QVector3D &value) {
+  const float data[3] = {value.x(), value.y(), value.z()};
+  const int location = Update(uniform, data, sizeof(data));
+  if (location >= 0) setUniformValue(location, value);
+}
+
+void ShaderProgram::SetUniform(Uniform uniform, const QColor &value) {
+  const float data[4] = {float(value.redF()), float(value.greenF()),
+                         float(value.blueF()), float(value.alphaF())};
+  const int location = Update(uniform, data, sizeof(data));
+  if (location >= 0) setUniformValue(location, value);
+}
+
+void ShaderProgram::SetUniform(Uniform uniform, const QMatrix4x4 &value) {
+  const int location = Update(uniform, value.constData(), 16 * sizeof(float));
+  if (location >= 0) setUniformValue(location, value);
+}
+
+}  // namespace s21
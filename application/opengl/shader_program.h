@@ -0,0 +1,71 @@
+#ifndef SHADER_PROGRAM_H_
+#define SHADER_PROGRAM_H_
+
+#include <QColor>
+#include <QMatrix4x4>
+#include <QOpenGLShaderProgram>
+#include <QVector2D>
+#include <QVector3D>
+
+namespace s21 {
+
+// Every uniform the viewer's shaders use. Programs that do not declare one
+// simply ignore it.
+enum class Uniform {
+  kProjection = 0,
+  kView,
+  kModel,
+  kViewPos,
+  kPositionOffset,
+  kPositionScale,
+  kPackedTangents,
+  kSkybox,
+  kMapAmbient,
+  kMapDiffuse,
+  kMapSpecular,
+  kMapNormal,
+  kMapHeight,
+  kThickness,
+  kViewportInvSize,
+  kPointColor,
+  kRoundPoint,
+  kPointSize,
+  kInstances,
+  kInstanceBase,
+  kCount
+};
+
+// A shader program with the locations of all uniforms resolved once after
+// linking. Uniform values belong to the program object, so the last value
+// sent is remembered and setting the same value again is a no-op.
+class ShaderProgram : public QOpenGLShaderProgram {
+ public:
+  // Call after every successful link, forgets the remembered values.
+  void ResolveUniforms();
+
+  // The program must be bound.
+  void SetUniform(Uniform uniform, float value);
+  void SetUniform(Uniform uniform, int value);
+  void SetUniform(Uniform uniform, bool value);
+  void SetUniform(Uniform uniform, const QVector2D &value);
+  void SetUniform(Uniform uniform, const QVector3D &value);
+  void SetUniform(Uniform uniform, const QColor &value);
+  void SetUniform(Uniform uniform, const QMatrix4x4 &value);
+
+ private:
+  struct Slot {
+    int location = -1;
+    bool known = false;
+    char value[16 * sizeof(float)];
+  };
+
+  // Remembers the value and returns the location when it has to be sent,
+  // or -1 when the uniform is missing or already holds the value.
+  int Update(Uniform uniform, const void *value, int bytes);
+
+  Slot m_slots_[int(Uniform::kCount)];
+};
+
+}  // namespace s21
+
+#endif  // SHADER_PROGRAM_H_
@@ -1,23 +1,109 @@
 #include "v3d_gl.h"
 
+#include <QElapsedTimer>
+#include <QFile>
+
+#include "buffer_arena.h"
+#include "mesh_simplifier.h"
+
 namespace s21 {
 
+namespace {
+
+// Screen-space error in pixels allowed before a coarser LOD is used, and how
+// many times it may double while the frame is over the triangle budget.
+const float kLodThreshold = 1.0f;
+const int kLodSteps = 8;
+
+// Puts the defines right after the #version line of a shader file, and
+// replaces that line when a version is given.
+QByteArray ReadShader(const QString &path, const QByteArray &defines,
+                      const QByteArray &version = QByteArray()) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return QByteArray();
+  }
+  QByteArray source = file.readAll();
+  if (!version.isEmpty()) {
+    source.replace(0, source.indexOf('\n'), version);
+  }
+  source.insert(source.indexOf('\n') + 1, defines);
+  return source;
+}
+
+}  // namespace
+
 V3D_GL::V3D_GL(QWidget *parent)
-    : QOpenGLWidget{parent}, m_camera_(QVector3D(1.0, 1.0, 1.0)) {}
+    : QOpenGLWidget{parent},
+      m_camera_(QVector3D(1.0, 1.0, 1.0)),
+      m_state_{*this},
+      m_triangle_budget_{MeshSimplifier::GetBudget()} {}
 
 V3D_GL::~V3D_GL() {
+  for (auto &&it : m_loaders_) {
+    delete it;
+  }
+  makeCurrent();
+  for (auto &&it : m_previews_) {
+    delete it;
+  }
+  m_previews_.clear();
+  m_lights_.Destroy(*this);
+  m_multi_draw_.Destroy(*this);
   for (auto &&it : m_models_) {
     it->Destroy();
   }
   m_models_.clear();
+  BufferArena::Destroy();
   delete m_scene_;
+  doneCurrent();
 }
 
 void V3D_GL::LoadModel(QString file) {
-  m_current_obj_ = Model::createModel(file);
-  connect(m_current_obj_, SIGNAL(Error(QString)), this, SIGNAL(Error(QString)));
-  m_models_.push_back(m_current_obj_);
-  emit curentObj(m_current_obj_);
+  ModelLoader *loader = new ModelLoader(file, this);
+  connect(loader, SIGNAL(Error(QString)), this, SIGNAL(Error(QString)));
+  connect(loader, SIGNAL(Progress(qint64, qint64, int, int, qint64)), this,
+          SIGNAL(LoadProgress(qint64, qint64, int, int, qint64)));
+  connect(loader, SIGNAL(finished()), this, SLOT(ModelLoaded()));
+  m_loaders_.push_back(loader);
+  m_previews_.insert(loader, new StreamMesh);
+  ++m_revision_;
+  loader->start();
+}
+
+void V3D_GL::CancelLoading() {
+  for (auto &&it : m_loaders_) {
+    it->Cancel();
+  }
+}
+
+void V3D_GL::ModelLoaded() {
+  ModelLoader *loader = qobject_cast<ModelLoader *>(sender());
+  m_loaders_.removeOne(loader);
+  Model *model = loader->TakeModel();
+  const QString path = loader->GetPath();
+  loader->deleteLater();
+
+  makeCurrent();
+  if (model) {
+    model->Upload();
+  }
+  delete m_previews_.take(loader);
+  doneCurrent();
+  ++m_revision_;
+
+  if (model) {
+
+    m_current_obj_ = model;
+    connect(m_current_obj_, SIGNAL(Error(QString)), this,
+            SIGNAL(Error(QString)));
+    m_models_.push_back(m_current_obj_);
+    emit curentObj(m_current_obj_);
+    emit ModelReady(path);
+  }
+  if (m_loaders_.isEmpty()) {
+    emit LoadFinished();
+  }
 }
 
 void V3D_GL::ChangeCurentObj(int index) {
@@ -30,15 +116,41 @@ void V3D_GL::ChangeCurentObj(int index) {
 }
 
 void V3D_GL::RemoveObj(int index) {
-  if (index >= 0 && index <= m_models_.size()) {
-    m_models_.remove(index);
+  if (index >= 0 && index < m_models_.size()) {
+    Model *model = m_models_.takeAt(index);
+    if (model == m_current_obj_) {
+      m_current_obj_ = nullptr;
+      emit curentObj(m_current_obj_);
+    }
+    makeCurrent();
+    model->Destroy();
+    // Removal is what leaves holes in the arena, so it is packed here.
+    if (BufferArena::IsFragmented()) {
+      BufferArena::Defragment();
+    }
+    doneCurrent();
+    ++m_revision_;
   }
 }
 
+void V3D_GL::DefragmentBuffers() {
+  makeCurrent();
+  BufferArena::Defragment();
+  doneCurrent();
+  ++m_revision_;
+}
+
 void V3D_GL::ModelFocus() {
   if (m_current_obj_) {
     QVector3D center = m_current_obj_->GetInfo().GetCenterModelVertex();
     m_camera_.ChangeFocus(center);
+  } else {
+    for (auto it : m_previews_) {
+      if (!it->IsEmpty()) {
+        m_camera_.ChangeFocus(it->GetCenter());
+        break;
+      }
+    }
   }
 }
 
@@ -80,6 +192,11 @@ void V3D_GL::mousePressEvent(QMouseEvent *event) {
 
 void V3D_GL::initializeGL() {
   initializeOpenGLFunctions();
+  BufferArena::Create(*this);
+  const InstanceData preview;
+  m_preview_instance_ =
+      BufferArena::Add(ArenaBuffer::kInstances, &preview, sizeof(preview));
+  m_lights_.Create(*this);
   LoadShaderProgram(m_shader_program_, ":/shader.vert", ":/shader.frag");
   LoadShaderProgram(m_shader_scene_, ":/scene.vert", ":/scene.frag");
   LoadShaderProgram(m_shader_vertex_, ":/vertex.vert", ":/vertex.frag");
@@ -91,6 +208,12 @@ void V3D_GL::initializeGL() {
   LoadShaderProgram(m_shader_program_flat_, ":/shader_flat.vert",
                     ":/shader_flat.frag");
   LoadShaderProgram(m_shader_cubemap, ":/cubemap.vert", ":/cubemap.frag");
+  if (m_multi_draw_.Create(m_state_, *context())) {
+    LoadShaderProgram(m_shader_material_multi_, ":/material.vert",
+                      ":/material.frag", nullptr, true);
+    LoadShaderProgram(m_shader_material_flat_multi_, ":/material_flat.vert",
+                      ":/material_flat.frag", nullptr, true);
+  }
 
   m_scene_ = new Scene(&m_shader_scene_, &m_shader_cubemap);
   m_scene_->SetProjectionViewAngle(m_camera_.GetZoom());
@@ -106,7 +229,7 @@ void V3D_GL::initializeGL() {
 
   glEnable(GL_MULTISAMPLE);
 
-  set_fps(m_timer_, 60.0f);
+  set_fps(60.0f);
   emit getSceneData();
 }
 
@@ -115,8 +238,8 @@ void V3D_GL::resizeGL([[maybe_unused]] int width, [[maybe_unused]] int height) {
   m_scene_->SetProjectionViewRatio(ratio);
 
   m_shader_edge_.bind();
-  m_shader_edge_.setUniformValue(
-      "u_viewportInvSize",
+  m_shader_edge_.SetUniform(
+      Uniform::kViewportInvSize,
       QVector2D((float)this->width(), (float)this->height()));
   m_shader_edge_.release();
 }
@@ -133,9 +256,15 @@ void V3D_GL::SetBackgroundColor(QColor color) {
   if (m_scene_) m_scene_->SetBackgroundColor(color);
 }
 
-void V3D_GL::OnSurfaceHardSmooth() { glDisable(GL_MULTISAMPLE); }
+void V3D_GL::OnSurfaceHardSmooth() {
+  glDisable(GL_MULTISAMPLE);
+  ++m_revision_;
+}
 
-void V3D_GL::OnSurfaceSoftSmooth() { glEnable(GL_MULTISAMPLE); }
+void V3D_GL::OnSurfaceSoftSmooth() {
+  glEnable(GL_MULTISAMPLE);
+  ++m_revision_;
+}
 
 void V3D_GL::SetLightType(LightType type) {
   m_illumination_.SetLightType(type);
@@ -146,16 +275,29 @@ void V3D_GL::SetDrawSceneType(DrawSceneType type) {
 }
 
 void V3D_GL::paintGL() {
+  QElapsedTimer timer;
+  timer.start();
   QColor color(m_scene_->GetBackgroundColor());
   glClearColor(color.redF(), color.greenF(), color.blueF(), color.alphaF());
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  m_state_.Reset();
+
+  SelectLods();
+  CullClusters();
+  m_lights_.Update(*this, m_illumination_);
+  UpdateQueues();
+  // Instances may have moved the buffer behind the texture.
+  m_state_.BindTexture(GlState::kInstanceUnit,
+                       BufferArena::GetInstanceTexture(), GL_TEXTURE_BUFFER);
 
   if (m_illumination_.GetLightType() == LightType::kSoft) {
-    DrawModelsMaterial(m_shader_material_);
-    DrawModelsTexture(m_shader_program_);
+    DrawSurfaces(m_shader_material_, m_shader_program_,
+                 m_shader_material_multi_);
+    DrawPreviews(m_shader_material_);
   } else {
-    DrawModelsMaterial(m_shader_material_flat_);
-    DrawModelsTexture(m_shader_program_flat_);
+    DrawSurfaces(m_shader_material_flat_, m_shader_program_flat_,
+                 m_shader_material_flat_multi_);
+    DrawPreviews(m_shader_material_flat_);
   }
 
   DrawModelsEdge(m_shader_edge_);
@@ -163,100 +305,219 @@ void V3D_GL::paintGL() {
 
   DrawScene(m_shader_scene_);
   DrawSkyBox(m_shader_cubemap);
+
+  const GlStateStats stats = m_state_.GetStats();
+  emit StateStats(stats.changes, stats.avoided, timer.nsecsElapsed() / 1000);
 }
 
-void V3D_GL::LoadShaderProgram(QOpenGLShaderProgram &shader, QString vert,
-                               QString frag, QString geom) {
-  if (!shader.addShaderFromSourceFile(QOpenGLShader::Vertex, vert)) {
+void V3D_GL::LoadShaderProgram(ShaderProgram &shader, QString vert,
+                               QString frag, QString geom, bool multi_draw) {
+  QByteArray defines = m_lights_.GetDefines();
+  QByteArray version;
+  if (multi_draw) {
+    defines += "#define MULTI_DRAW\n";
+    version = "#version 430 core";
+  }
+  if (!shader.addShaderFromSourceCode(QOpenGLShader::Vertex,
+                                      ReadShader(vert, defines, version))) {
     emit Error(QString("failed add shader vertex"));
   }
 
   if (geom != nullptr) {
-    if (!shader.addShaderFromSourceFile(QOpenGLShader::Geometry, geom)) {
+    if (!shader.addShaderFromSourceCode(QOpenGLShader::Geometry,
+                                        ReadShader(geom, defines, version))) {
       emit Error(QString("failed add shader geometry"));
     }
   }
 
-  if (!shader.addShaderFromSourceFile(QOpenGLShader::Fragment, frag)) {
+  if (!shader.addShaderFromSourceCode(QOpenGLShader::Fragment,
+                                      ReadShader(frag, defines, version))) {
     emit Error(QString("failed add shader fragment"));
   }
 
   if (!shader.link()) {
     emit Error(QString("failed link"));
   }
+  shader.ResolveUniforms();
+  m_lights_.Bind(*this, shader);
+  const GLuint material =
+      glGetUniformBlockIndex(shader.programId(), "MaterialBlock");
+  if (material != GL_INVALID_INDEX) {
+    glUniformBlockBinding(shader.programId(), material,
+                          MaterialBlock::kBinding);
+  }
 
   if (!shader.bind()) {
     emit Error(QString("failed bind"));
   }
+  shader.SetUniform(Uniform::kInstances, GlState::kInstanceUnit);
 }
 
-void V3D_GL::DrawModelsMaterial(QOpenGLShaderProgram &shader) {
-  shader.bind();
-  shader.setUniformValue("projection", m_scene_->GetProjectionMat());
-  shader.setUniformValue("view", m_camera_.GetViewMatrix());
-  shader.setUniformValue("viewPos", m_camera_.GetPosition());
+void V3D_GL::DrawSurfaces(ShaderProgram &material, ShaderProgram &texture,
+                          ShaderProgram &multi) {
+  const QVector<RenderItem> &items = m_surface_queue_.GetItems();
+  // The material program sorts first, so its draws are a prefix of the
+  // queue. Textures are bound per run and keep their own draws.
+  int first = 0;
+  if (m_multi_draw_.IsEnabled()) {
+    while (first < items.size() && RenderQueue::GetProgram(items[first].key) ==
+                                       RenderQueue::kProgramMaterial) {
+      ++first;
+    }
+  }
+  if (first) {
+    multi.bind();
+    multi.SetUniform(Uniform::kProjection, m_scene_->GetProjectionMat());
+    multi.SetUniform(Uniform::kView, m_camera_.GetViewMatrix());
+    multi.SetUniform(Uniform::kViewPos, m_camera_.GetPosition());
+    multi.SetUniform(Uniform::kSkybox, 50);
+    m_multi_draw_.Draw(m_state_, items, 0, first);
+    multi.release();
+  }
+
+  ShaderProgram *const programs[] = {&material, &texture};
+  ShaderProgram *shader = nullptr;
+  Model *model = nullptr;
+  for (int i = first; i < items.size(); ++i) {
+    const RenderItem &it = items[i];
+    ShaderProgram *program = programs[RenderQueue::GetProgram(it.key)];
+    if (program != shader) {
+      shader = program;
+      shader->bind();
+      shader->SetUniform(Uniform::kProjection, m_scene_->GetProjectionMat());
+      shader->SetUniform(Uniform::kView, m_camera_.GetViewMatrix());
+      shader->SetUniform(Uniform::kViewPos, m_camera_.GetPosition());
+      model = nullptr;
+    }
+    if (it.model != model) {
+      model = it.model;
+      shader->SetUniform(Uniform::kModel,
+                         m_scene_->GetTransformMat() * model->GetModelMatrix());
+      shader->SetUniform(Uniform::kInstanceBase, model->GetInstanceBase());
+    }
+    if (shader == &texture) {
+      it.mesh->DrawTexture(model->GetSettings(), *shader, m_state_, it.begin,
+                           it.end, model->GetInstanceCount());
+    } else {
+      it.mesh->DrawMaterial(model->GetSettings(), *shader, m_state_,
+                            it.begin, it.end, model->GetInstanceCount());
+    }
+  }
+  if (shader) {
+    shader->release();
+  }
+}
 
-  LightsOn(shader);
+void V3D_GL::DrawPreviews(ShaderProgram &shader) {
+  if (m_previews_.isEmpty()) return;
 
-  for (auto &it : m_models_) {
-    shader.setUniformValue("model",
-                           m_scene_->GetTransformMat() * it->GetModelMatrix());
-    it->DrawMaterial(shader);
+  shader.bind();
+  shader.SetUniform(Uniform::kProjection, m_scene_->GetProjectionMat());
+  shader.SetUniform(Uniform::kView, m_camera_.GetViewMatrix());
+  shader.SetUniform(Uniform::kViewPos, m_camera_.GetPosition());
+  shader.SetUniform(Uniform::kModel, m_scene_->GetTransformMat());
+  shader.SetUniform(Uniform::kInstanceBase,
+                    BufferArena::GetBaseInstance(m_preview_instance_));
+
+  for (auto it = m_previews_.begin(); it != m_previews_.end(); ++it) {
+    it.value()->Append(*this, it.key()->GetStream().Take());
+    it.value()->Draw(m_state_, shader);
   }
 
   shader.release();
 }
 
-void V3D_GL::DrawModelsTexture(QOpenGLShaderProgram &shader) {
-  shader.bind();
-  shader.setUniformValue("projection", m_scene_->GetProjectionMat());
-  shader.setUniformValue("view", m_camera_.GetViewMatrix());
-  shader.setUniformValue("viewPos", m_camera_.GetPosition());
+void V3D_GL::SetTriangleBudget(int budget) {
+  m_triangle_budget_ = budget;
+  ++m_revision_;
+}
+
+void V3D_GL::SetContinuous(bool continuous) { m_continuous_ = continuous; }
+
+void V3D_GL::AcquireContinuous() { ++m_continuous_holds_; }
 
-  LightsOn(shader);
+void V3D_GL::ReleaseContinuous() {
+  if (m_continuous_holds_ > 0) --m_continuous_holds_;
+}
+
+quint64 V3D_GL::GetSceneStamp() const {
+  quint64 stamp = m_revision_;
+  auto mix = [&stamp](quint64 value) { stamp = stamp * 1000003u ^ value; };
+  mix(m_scene_->GetRevision());
+  mix(m_models_.size());
+  for (auto &&it : m_models_) {
+    mix(it->GetRevision());
+  }
+  return stamp;
+}
+
+quint64 V3D_GL::GetStateStamp() const {
+  quint64 stamp = GetSceneStamp();
+  auto mix = [&stamp](quint64 value) { stamp = stamp * 1000003u ^ value; };
+  mix(m_camera_.GetRevision());
+  mix(m_illumination_.GetRevision());
+  for (auto &&it : m_loaders_) {
+    mix(it->GetStream().GetFaces());
+  }
+  return stamp;
+}
+
+void V3D_GL::UpdateQueues() {
+  const quint64 stamp = GetSceneStamp();
+  if (stamp == m_queue_stamp_) return;
+  m_queue_stamp_ = stamp;
 
   for (auto &it : m_models_) {
-    shader.setUniformValue("model",
-                           m_scene_->GetTransformMat() * it->GetModelMatrix());
-    it->DrawTexture(shader);
+    it->UpdateMaterials();
+    it->UpdateInstances();
   }
+  const QMatrix4x4 view =
+      m_camera_.GetViewMatrix() * m_scene_->GetTransformMat();
+  m_surface_queue_.Build(RenderPass::kSurface, m_models_, view);
+  m_multi_draw_.Update(m_state_, m_surface_queue_.GetItems(),
+                       m_scene_->GetTransformMat());
+  m_edge_queue_.Build(RenderPass::kEdge, m_models_, view);
+  m_vertex_queue_.Build(RenderPass::kVertex, m_models_, view);
+}
 
-  shader.release();
+void V3D_GL::RenderIfDirty() {
+  const quint64 stamp = GetStateStamp();
+  if (m_continuous_ || m_continuous_holds_ > 0 || stamp != m_rendered_stamp_) {
+    m_rendered_stamp_ = stamp;
+    update();
+  }
 }
 
-void V3D_GL::LightsOn(QOpenGLShaderProgram &shader) {
-  QMap<QString, QVector<QVariant> *> m_lights = m_illumination_.GetAllLight();
-  for (auto &vector : m_lights) {
-    QString type_vector(m_lights.key(vector));
-    int count = 0;
-    for (auto &it : *vector) {
-      if (m_illumination_.HasItem(m_lights.key(vector), vector->indexOf(it))) {
-        if (m_illumination_.ItemIsActive(it)) {
-          QMap<QString, QVariant> light_info = m_illumination_.GetLightInfo(
-              m_lights.key(vector), vector->indexOf(it));
-
-          QString item_name = type_vector + "[" + QString::number(count) + "]";
-          QString uniform;
-          for (auto &property : light_info) {
-            uniform = light_info.key(property).prepend(item_name);
-            if (QString(property.typeName()) == "QVector3D*") {
-              shader.setUniformValue(uniform.toStdString().c_str(),
-                                     *property.value<QVector3D *>());
-            } else {
-              shader.setUniformValue(uniform.toStdString().c_str(),
-                                     *property.value<float *>());
-            }
-          }
-          count++;
-        }
-      }
+void V3D_GL::SelectLods() {
+  const QMatrix4x4 view =
+      m_camera_.GetViewMatrix() * m_scene_->GetTransformMat();
+  const QMatrix4x4 projection = m_scene_->GetProjectionMat();
+  float threshold = kLodThreshold;
+  for (int i = 0; i < kLodSteps; ++i) {
+    qint64 triangles = 0;
+    for (auto &it : m_models_) {
+      triangles += it->SelectLods(view, projection, height(), threshold);
     }
-    shader.setUniformValue(QString("Count" + type_vector).toStdString().c_str(),
-                           count);
+    if (!m_triangle_budget_ || triangles <= m_triangle_budget_) {
+      break;
+    }
+    threshold *= 2.0f;
   }
 }
 
-void V3D_GL::addLight(QString type) { m_illumination_.addLight(type); }
+void V3D_GL::CullClusters() {
+  const QMatrix4x4 view =
+      m_camera_.GetViewMatrix() * m_scene_->GetTransformMat();
+  const QMatrix4x4 projection = m_scene_->GetProjectionMat();
+  ClusterStats stats;
+  for (auto &it : m_models_) {
+    it->CullClusters(view, projection, stats);
+  }
+  emit FrameStats(stats.clusters, stats.frustum_culled, stats.cone_culled,
+                  stats.triangles);
+}
+
+int V3D_GL::addLight(QString type) { return m_illumination_.addLight(type); }
 
 void V3D_GL::setEnableLight(QString type, int index) {
   m_illumination_.SetItemStatus(type, index, true);
@@ -266,59 +527,72 @@ void V3D_GL::setDisableLight(QString type, int index) {
   m_illumination_.SetItemStatus(type, index, false);
 }
 
-void V3D_GL::DrawModelsEdge(QOpenGLShaderProgram &shader) {
+void V3D_GL::DrawModelsEdge(ShaderProgram &shader) {
   shader.bind();
-  shader.setUniformValue("projection", m_scene_->GetProjectionMat());
-  shader.setUniformValue("view", m_camera_.GetViewMatrix());
-
-  for (auto &it : m_models_) {
-    shader.setUniformValue("model",
-                           m_scene_->GetTransformMat() * it->GetModelMatrix());
-    it->DrawEdge(shader);
+  shader.SetUniform(Uniform::kProjection, m_scene_->GetProjectionMat());
+  shader.SetUniform(Uniform::kView, m_camera_.GetViewMatrix());
+
+  Model *model = nullptr;
+  for (const RenderItem &it : m_edge_queue_.GetItems()) {
+    if (it.model != model) {
+      model = it.model;
+      shader.SetUniform(Uniform::kModel,
+                        m_scene_->GetTransformMat() * model->GetModelMatrix());
+      shader.SetUniform(Uniform::kInstanceBase, model->GetInstanceBase());
+    }
+    it.mesh->DrawEdge(model->GetSettings(), shader, m_state_,
+                      model->GetInstanceCount());
   }
 }
 
-void V3D_GL::DrawModelsVertex(QOpenGLShaderProgram &shader) {
+void V3D_GL::DrawModelsVertex(ShaderProgram &shader) {
   shader.bind();
-  shader.setUniformValue("projection", m_scene_->GetProjectionMat());
-  shader.setUniformValue("view", m_camera_.GetViewMatrix());
-
-  for (auto &it : m_models_) {
-    shader.setUniformValue("model",
-                           m_scene_->GetTransformMat() * it->GetModelMatrix());
-    it->DrawVertex(shader);
+  shader.SetUniform(Uniform::kProjection, m_scene_->GetProjectionMat());
+  shader.SetUniform(Uniform::kView, m_camera_.GetViewMatrix());
+
+  Model *model = nullptr;
+  for (const RenderItem &it : m_vertex_queue_.GetItems()) {
+    if (it.model != model) {
+      model = it.model;
+      shader.SetUniform(Uniform::kModel,
+                        m_scene_->GetTransformMat() * model->GetModelMatrix());
+      shader.SetUniform(Uniform::kInstanceBase, model->GetInstanceBase());
+    }
+    it.mesh->DrawVertex(model->GetSettings(), shader, m_state_,
+                        model->GetInstanceCount());
   }
 }
 
-void V3D_GL::DrawScene(QOpenGLShaderProgram &shader) {
+void V3D_GL::DrawScene(ShaderProgram &shader) {
   if (m_scene_->GetDrawType() == DrawSceneType::kDraw) {
     shader.bind();
 
-    shader.setUniformValue("projection", m_scene_->GetProjectionMat());
-    shader.setUniformValue("view", m_camera_.GetViewMatrix());
+    shader.SetUniform(Uniform::kProjection, m_scene_->GetProjectionMat());
+    shader.SetUniform(Uniform::kView, m_camera_.GetViewMatrix());
 
     m_scene_->DrawAxis();
     m_scene_->DrawGrid();
   }
 }
 
-void V3D_GL::DrawSkyBox(QOpenGLShaderProgram &shader) {
+void V3D_GL::DrawSkyBox(ShaderProgram &shader) {
   glDepthFunc(GL_LEQUAL);
   shader.bind();
 
-  shader.setUniformValue("projection", m_scene_->GetProjectionMat());
+  shader.SetUniform(Uniform::kProjection, m_scene_->GetProjectionMat());
 
-  shader.setUniformValue(
-      "view", QMatrix4x4(m_camera_.GetViewMatrix().toGenericMatrix<3, 3>()));
+  shader.SetUniform(
+      Uniform::kView,
+      QMatrix4x4(m_camera_.GetViewMatrix().toGenericMatrix<3, 3>()));
 
   m_scene_->DrawSkyBox();
   glDepthFunc(GL_LESS);
 }
 
-void V3D_GL::set_fps(QTimer *timer, GLfloat fps) {
-  timer = new QTimer(this);
-  connect(timer, SIGNAL(timeout()), this, SLOT(update()));
-  timer->start(1000 / fps);
+void V3D_GL::set_fps(GLfloat fps) {
+  m_timer_ = new QTimer(this);
+  connect(m_timer_, SIGNAL(timeout()), this, SLOT(RenderIfDirty()));
+  m_timer_->start(1000 / fps);
 }
 
 }  // namespace s21
@@ -1,6 +1,7 @@
 #ifndef V3D_GL_H
 #define V3D_GL_H
 
+#include <QHash>
 #include <QKeyEvent>
 #include <QMatrix4x4>
 #include <QOpenGLFunctions_4_1_Core>
@@ -10,9 +11,16 @@
 #include <QtMath>
 
 #include "camera.h"
+#include "gl_state.h"
 #include "illumination.h"
+#include "light_buffer.h"
 #include "model.h"
+#include "model_loader.h"
+#include "multi_draw.h"
+#include "render_queue.h"
 #include "scene.h"
+#include "shader_program.h"
+#include "stream_mesh.h"
 
 namespace s21 {
 
@@ -43,10 +51,19 @@ class V3D_GL : public QOpenGLWidget, protected QOpenGLFunctions_4_1_Core {
 
   void ChangeCurentObj(int index);
   void RemoveObj(int index);
+  // Packs the shared geometry buffers, see BufferArena.
+  void DefragmentBuffers();
 
   void ModelFocus();
   float GetModelRatioToIndentify();
   Illumination *GetIllumation() { return &m_illumination_; }
+  void SetTriangleBudget(int budget);
+
+  // Renders on every tick instead of only after a state change. Holds are
+  // counted, so a GIF recording keeps rendering while the user toggles it.
+  void SetContinuous(bool continuous);
+  void AcquireContinuous();
+  void ReleaseContinuous();
 
  protected:
   virtual void initializeGL() override;
@@ -54,45 +71,86 @@ class V3D_GL : public QOpenGLWidget, protected QOpenGLFunctions_4_1_Core {
   virtual void paintGL() override;
 
  private:
-  void LoadShaderProgram(QOpenGLShaderProgram &shader, QString vert,
-                         QString frag, QString geom = nullptr);
-  void DrawModelsMaterial(QOpenGLShaderProgram &shader);
-  void DrawModelsTexture(QOpenGLShaderProgram &shader);
-  void DrawModelsEdge(QOpenGLShaderProgram &shader);
-  void DrawModelsVertex(QOpenGLShaderProgram &shader);
-  void DrawScene(QOpenGLShaderProgram &shader);
-  void DrawSkyBox(QOpenGLShaderProgram &shader);
-  void set_fps(QTimer *timer, GLfloat fps);
-
-  void LightsOn(QOpenGLShaderProgram &shader);
-
-  QOpenGLShaderProgram m_shader_program_;
-  QOpenGLShaderProgram m_shader_scene_;
-  QOpenGLShaderProgram m_shader_vertex_;
-  QOpenGLShaderProgram m_shader_edge_;
-  QOpenGLShaderProgram m_shader_material_;
-  QOpenGLShaderProgram m_shader_material_flat_;
-  QOpenGLShaderProgram m_shader_program_flat_;
-  QOpenGLShaderProgram m_shader_cubemap;
+  // multi_draw builds the GL 4.3 variant that reads its draws from
+  // MultiDraw.
+  void LoadShaderProgram(ShaderProgram &shader, QString vert,
+                         QString frag, QString geom = nullptr,
+                         bool multi_draw = false);
+  // The material draws go through multi when multi-draw is available.
+  void DrawSurfaces(ShaderProgram &material, ShaderProgram &texture,
+                    ShaderProgram &multi);
+  void DrawPreviews(ShaderProgram &shader);
+  void DrawModelsEdge(ShaderProgram &shader);
+  void DrawModelsVertex(ShaderProgram &shader);
+  void DrawScene(ShaderProgram &shader);
+  void DrawSkyBox(ShaderProgram &shader);
+  void set_fps(GLfloat fps);
+  // Covers everything the render queues depend on, the camera aside.
+  quint64 GetSceneStamp() const;
+  quint64 GetStateStamp() const;
+  void UpdateQueues();
+
+  void SelectLods();
+  void CullClusters();
+
+  ShaderProgram m_shader_program_;
+  ShaderProgram m_shader_scene_;
+  ShaderProgram m_shader_vertex_;
+  ShaderProgram m_shader_edge_;
+  ShaderProgram m_shader_material_;
+  ShaderProgram m_shader_material_flat_;
+  ShaderProgram m_shader_program_flat_;
+  ShaderProgram m_shader_cubemap;
+  ShaderProgram m_shader_material_multi_;
+  ShaderProgram m_shader_material_flat_multi_;
 
   Scene *m_scene_ = nullptr;
   Camera m_camera_;
 
   QVector<Model *> m_models_;
+  QVector<ModelLoader *> m_loaders_;
+  QHash<ModelLoader *, StreamMesh *> m_previews_;
   Model *m_current_obj_ = nullptr;
 
   Illumination m_illumination_;
+  LightBuffer m_lights_;
+  GlState m_state_;
+  RenderQueue m_surface_queue_;
+  RenderQueue m_edge_queue_;
+  RenderQueue m_vertex_queue_;
+  MultiDraw m_multi_draw_;
+  // Identity placement for the previews, which draw without instances.
+  int m_preview_instance_ = -1;
+  quint64 m_queue_stamp_ = ~quint64(0);
 
   QPoint m_last_pos_;
-  QTimer *m_timer_;
+  QTimer *m_timer_ = nullptr;
+
+  int m_triangle_budget_ = 0;
+
+  // Grows on changes that live in the widget itself, such as the model list.
+  quint64 m_revision_ = 0;
+  quint64 m_rendered_stamp_ = 0;
+  bool m_continuous_ = false;
+  int m_continuous_holds_ = 0;
 
  signals:
   void curentObj(Model *);
   void getSceneData();
   void Error(QString);
+  void LoadProgress(qint64, qint64, int, int, qint64);
+  void ModelReady(QString);
+  void LoadFinished();
+  void FrameStats(qint64, qint64, qint64, qint64);
+  void StateStats(qint64, qint64, qint64);
+
+ private slots:
+  void ModelLoaded();
+  void RenderIfDirty();
 
  public slots:
-  void addLight(QString);
+  void CancelLoading();
+  int addLight(QString);
   void setEnableLight(QString, int);
   void setDisableLight(QString, int);
 };
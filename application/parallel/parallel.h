@@ -0,0 +1,46 @@
+#ifndef PARALLEL_H_
+#define PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace s21 {
+
+inline size_t WorkerCount() {
+  return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+template <typename Function>
+void ParallelFor(size_t count, Function &&function) {
+  const size_t workers = std::min(WorkerCount(), count);
+  if (workers <= 1) {
+    for (size_t i = 0; i < count; ++i) {
+      function(i);
+    }
+    return;
+  }
+
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    for (size_t i = next++; i < count; i = next++) {
+      function(i);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(workers - 1);
+  for (size_t i = 1; i < workers; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto &it : threads) {
+    it.join();
+  }
+}
+
+}  // namespace s21
+
+#endif  // PARALLEL_H_
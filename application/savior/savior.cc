@@ -45,6 +45,7 @@ void Savior::SaveBmp() {
 void Savior::SaveGif() {
   file_format_ = "GIF Animation (*.gif)";
   m_gif_flag_ = true;
+  m_gl_parent_->AcquireContinuous();
   GifToThread *gif_thread = new GifToThread(buffer_);
 
   connect(gif_thread, SIGNAL(GetNewFrame()), this, SLOT(SendNewFrame()));
@@ -132,7 +133,10 @@ void Savior::CloseBuffer() {
   emit RecordDone();
 }
 
-void Savior::RecordGif() { CloseBuffer(); }
+void Savior::RecordGif() {
+  m_gl_parent_->ReleaseContinuous();
+  CloseBuffer();
+}
 
 void Savior::SwitchToPopup() {
   setWindowFlags(Qt::WindowStaysOnTopHint | Qt::Popup);
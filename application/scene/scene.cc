@@ -2,7 +2,7 @@
 
 namespace s21 {
 
-Scene::Scene(QOpenGLShaderProgram *shader, QOpenGLShaderProgram *cube_shader)
+Scene::Scene(ShaderProgram *shader, ShaderProgram *cube_shader)
     : VBO(QOpenGLBuffer::VertexBuffer),
       m_projection_type{ProjectionType::kPerspective},
       m_program{shader},
@@ -30,30 +30,30 @@ void Scene::DrawAxis() {
   VAO.bind();
   m_model.setToIdentity();
 
-  m_program->setUniformValue("PointColor", x_axis_color);
-  m_program->setUniformValue("model", m_model);
+  m_program->SetUniform(Uniform::kPointColor, x_axis_color);
+  m_program->SetUniform(Uniform::kModel, m_model);
   glDrawArrays(GL_LINES, 0, 6);
 
   m_model.rotate(90.0f, 0.0f, 1.0f, 0.0f);
-  m_program->setUniformValue("PointColor", y_axis_color);
-  m_program->setUniformValue("model", m_model);
+  m_program->SetUniform(Uniform::kPointColor, y_axis_color);
+  m_program->SetUniform(Uniform::kModel, m_model);
   glDrawArrays(GL_LINES, 0, 6);
 
   m_model.rotate(90.0f, 0.0f, 0.0f, 1.0f);
-  m_program->setUniformValue("PointColor", z_axis_color);
-  m_program->setUniformValue("model", m_model);
+  m_program->SetUniform(Uniform::kPointColor, z_axis_color);
+  m_program->SetUniform(Uniform::kModel, m_model);
   glDrawArrays(GL_LINES, 0, 6);
   VAO.release();
 }
 
 void Scene::DrawGrid() {
   VAO.bind();
-  m_program->setUniformValue("PointColor", grid_color);
+  m_program->SetUniform(Uniform::kPointColor, grid_color);
 
   m_model.setToIdentity();
   m_model.translate(0.0f, 0.0f, -100.0f);
   for (int i = 0; i <= 200; ++i) {
-    m_program->setUniformValue("model", m_model);
+    m_program->SetUniform(Uniform::kModel, m_model);
     glDrawArrays(GL_LINES, 0, 6);
     m_model.translate(0.0f, 0.0f, 1.0f);
   }
@@ -63,7 +63,7 @@ void Scene::DrawGrid() {
   m_model.translate(0.0f, 0.0f, -100.0f);
 
   for (int i = 0; i <= 200; ++i) {
-    m_program->setUniformValue("model", m_model);
+    m_program->SetUniform(Uniform::kModel, m_model);
     glDrawArrays(GL_LINES, 0, 6);
     m_model.translate(0.0f, 0.0f, 1.0f);
   }
@@ -104,17 +104,39 @@ const QOpenGLTexture &Scene::GetCubeTexture() const { return m_cube_texture; }
 
 SceneTransformMatrix &Scene::GetSceneMat() { return scene_transform; }
 
-void Scene::SetProjectionType(ProjectionType type) { m_projection_type = type; }
+quint64 Scene::GetRevision() const {
+  return m_revision + scene_transform.GetRevision();
+}
+
+void Scene::SetProjectionType(ProjectionType type) {
+  m_projection_type = type;
+  ++m_revision;
+}
 
-void Scene::SetSkyboxType(SkyboxType type) { m_skybox_type = type; }
+void Scene::SetSkyboxType(SkyboxType type) {
+  m_skybox_type = type;
+  ++m_revision;
+}
 
-void Scene::SetProjectionViewAngle(float angle) { m_view_angle = angle; }
+void Scene::SetProjectionViewAngle(float angle) {
+  m_view_angle = angle;
+  ++m_revision;
+}
 
-void Scene::SetProjectionViewRatio(float ratio) { m_view_ratio = ratio; }
+void Scene::SetProjectionViewRatio(float ratio) {
+  m_view_ratio = ratio;
+  ++m_revision;
+}
 
-void Scene::SetBackgroundColor(QColor color) { m_background_color = color; }
+void Scene::SetBackgroundColor(QColor color) {
+  m_background_color = color;
+  ++m_revision;
+}
 
-void Scene::SetDrawType(DrawSceneType type) { m_draw_type = type; }
+void Scene::SetDrawType(DrawSceneType type) {
+  m_draw_type = type;
+  ++m_revision;
+}
 
 void Scene::UpdateProjection() {
   m_projection.setToIdentity();
@@ -204,7 +226,7 @@ void Scene::SetupMesh() {
   m_program_cube->enableAttributeArray(0);
   m_program_cube->setAttributeBuffer(0, GL_FLOAT, 0, 3, sizeof(QVector3D));
 
-  m_program_cube->setUniformValue("skybox", 50);
+  m_program_cube->SetUniform(Uniform::kSkybox, 50);
 
   cube_VAO.release();
   cube_VBO.release();
@@ -215,32 +237,56 @@ QMatrix4x4 SceneTransformMatrix::GetMatrix() {
   return matrix;
 }
 
-void SceneTransformMatrix::SetTranslateX(float shift) { translate.Tx = shift; }
+quint64 SceneTransformMatrix::GetRevision() const { return revision; }
 
-void SceneTransformMatrix::SetTranslateY(float shift) { translate.Ty = shift; }
+void SceneTransformMatrix::SetTranslateX(float shift) {
+  translate.Tx = shift;
+  ++revision;
+}
+
+void SceneTransformMatrix::SetTranslateY(float shift) {
+  translate.Ty = shift;
+  ++revision;
+}
 
-void SceneTransformMatrix::SetTranslateZ(float shift) { translate.Tz = shift; }
+void SceneTransformMatrix::SetTranslateZ(float shift) {
+  translate.Tz = shift;
+  ++revision;
+}
 
 void SceneTransformMatrix::SetRotateX(float rotate) {
   this->rotate.Rx = rotate;
+  ++revision;
 }
 
 void SceneTransformMatrix::SetRotateY(float rotate) {
   this->rotate.Ry = rotate;
+  ++revision;
 }
 
 void SceneTransformMatrix::SetRotateZ(float rotate) {
   this->rotate.Rz = rotate;
+  ++revision;
 }
 
-void SceneTransformMatrix::SetScaleX(float rotate) { this->scale.Sx = rotate; }
+void SceneTransformMatrix::SetScaleX(float rotate) {
+  this->scale.Sx = rotate;
+  ++revision;
+}
 
-void SceneTransformMatrix::SetScaleY(float rotate) { this->scale.Sy = rotate; }
+void SceneTransformMatrix::SetScaleY(float rotate) {
+  this->scale.Sy = rotate;
+  ++revision;
+}
 
-void SceneTransformMatrix::SetScaleZ(float rotate) { this->scale.Sz = rotate; }
+void SceneTransformMatrix::SetScaleZ(float rotate) {
+  this->scale.Sz = rotate;
+  ++revision;
+}
 
 void SceneTransformMatrix::SetScaleTotal(float rotate) {
   this->scale.STotal = rotate;
+  ++revision;
 }
 
 TranslateSetting &SceneTransformMatrix::GetTranslateSetting() {
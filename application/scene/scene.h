@@ -4,11 +4,11 @@
 #include <QColor>
 #include <QMatrix4x4>
 #include <QOpenGLBuffer>
-#include <QOpenGLShaderProgram>
 #include <QOpenGLTexture>
 #include <QOpenGLVertexArrayObject>
 
 #include "model_settings.h"
+#include "shader_program.h"
 
 namespace s21 {
 
@@ -22,9 +22,11 @@ struct SceneTransformMatrix {
   TranslateSetting translate{0.0f, 0.0f, 0.0f};
   RotateSetting rotate{0.0f, 0.0f, 0.0f};
   ScaleSetting scale{1.0f, 1.0f, 1.0f, 1.0f};
+  quint64 revision = 0;
 
  public:
   QMatrix4x4 GetMatrix();
+  quint64 GetRevision() const;
   void SetTranslateX(float shift);
   void SetTranslateY(float shift);
   void SetTranslateZ(float shift);
@@ -59,8 +61,8 @@ class Scene {
   float m_view_angle = 45.0f;
   float m_view_ratio = 1.0f;
 
-  QOpenGLShaderProgram *m_program;
-  QOpenGLShaderProgram *m_program_cube;
+  ShaderProgram *m_program;
+  ShaderProgram *m_program_cube;
 
   float vertices[6] = {
       100.0f, 0.0f, 0.0f, -100.0f, 0.0f, 0.0f,
@@ -75,6 +77,7 @@ class Scene {
   QColor m_background_color;
   SkyboxType m_skybox_type = SkyboxType::kDraw;
   DrawSceneType m_draw_type = DrawSceneType::kNo;
+  quint64 m_revision = 0;
 
   QString skybox[6] = {":/right.jpg",  ":/left.jpg",  ":/top.jpg",
                        ":/bottom.jpg", ":/front.jpg", ":/back.jpg"};
@@ -103,8 +106,7 @@ class Scene {
       {+1.0f, -1.0f, -1.0f}, {-1.0f, -1.0f, +1.0f}, {+1.0f, -1.0f, +1.0f}};
 
  public:
-  explicit Scene(QOpenGLShaderProgram *shader,
-                 QOpenGLShaderProgram *cube_shader);
+  explicit Scene(ShaderProgram *shader, ShaderProgram *cube_shader);
   ~Scene();
 
   void DrawAxis();
@@ -119,6 +121,8 @@ class Scene {
   const QOpenGLTexture &GetCubeTexture() const;
 
   SceneTransformMatrix &GetSceneMat();
+  // Grows on every setter call, including the scene transform.
+  quint64 GetRevision() const;
 
   void SetProjectionType(ProjectionType type);
   void SetSkyboxType(SkyboxType type);
@@ -56,6 +56,7 @@ class ModelSettings : public GlobalSetting {
   ScaleSetting m_scale_;
   QString m_parent_name_;
   SurfaceType m_surface_ = SurfaceType::kMaterial;
+  quint64 m_revision_ = 0;
 
  public:
   ModelSettings()
@@ -92,6 +93,7 @@ class ModelSettings : public GlobalSetting {
       this->m_scale_ = other.m_scale_;
       this->m_parent_name_ = other.m_parent_name_;
       this->m_surface_ = other.m_surface_;
+      ++this->m_revision_;
     }
     return *this;
   };
@@ -172,76 +174,114 @@ class ModelSettings : public GlobalSetting {
 
   SurfaceType GetSurfaceSettings() const { return m_surface_; }
 
-  void SetEdgeColor(const QColor color) { m_edge_.color = color; }
+  quint64 GetRevision() const { return m_revision_; }
+
+  void SetEdgeColor(const QColor color) {
+    m_edge_.color = color;
+    ++m_revision_;
+  }
 
   void SetEdgeSize(const float size) {
     if (size > 0.0f) {
       m_edge_.size = size;
     }
+    ++m_revision_;
   }
 
-  void SetEdgeType(const EdgeType type) { m_edge_.type = type; }
+  void SetEdgeType(const EdgeType type) {
+    m_edge_.type = type;
+    ++m_revision_;
+  }
 
-  void SetVertexColor(const QColor color) { m_vertex_.color = color; }
+  void SetVertexColor(const QColor color) {
+    m_vertex_.color = color;
+    ++m_revision_;
+  }
 
   void SetVertexSize(const float size) {
     if (size > 0.0f) {
       m_vertex_.size = size;
     }
+    ++m_revision_;
   }
 
-  void SetVertexType(const VertexType type) { m_vertex_.type = type; }
+  void SetVertexType(const VertexType type) {
+    m_vertex_.type = type;
+    ++m_revision_;
+  }
 
-  void SetTextureType(const TextureType type) { m_texture_.type = type; }
+  void SetTextureType(const TextureType type) {
+    m_texture_.type = type;
+    ++m_revision_;
+  }
 
-  void SetSurfaceType(const SurfaceType type) { m_surface_ = type; }
+  void SetSurfaceType(const SurfaceType type) {
+    m_surface_ = type;
+    ++m_revision_;
+  }
 
-  void SetTranslateX(const float shift) { m_translate_.Tx = shift; }
+  void SetTranslateX(const float shift) {
+    m_translate_.Tx = shift;
+    ++m_revision_;
+  }
 
-  void SetTranslateY(const float shift) { m_translate_.Ty = shift; }
+  void SetTranslateY(const float shift) {
+    m_translate_.Ty = shift;
+    ++m_revision_;
+  }
 
-  void SetTranslateZ(const float shift) { m_translate_.Tz = shift; }
+  void SetTranslateZ(const float shift) {
+    m_translate_.Tz = shift;
+    ++m_revision_;
+  }
 
   void SetRotateX(const float degree) {
     if (degree >= 0.0f && degree <= 360.0f) {
       m_rotate_.Rx = degree;
     }
+    ++m_revision_;
   }
 
   void SetRotateY(const float degree) {
     if (degree >= 0.0f && degree <= 360.0f) {
       m_rotate_.Ry = degree;
     }
+    ++m_revision_;
   }
 
   void SetRotateZ(const float degree) {
     if (degree >= 0.0f && degree <= 360.0f) {
       m_rotate_.Rz = degree;
     }
+    ++m_revision_;
   }
 
   void SetScaleX(const float scale) {
     if (scale > 0.0f) {
       this->m_scale_.Sx = scale;
     }
+    ++m_revision_;
   }
 
   void SetScaleY(const float scale) {
     if (scale > 0.0f) {
       this->m_scale_.Sy = scale;
     }
+    ++m_revision_;
   }
 
   void SetScaleZ(const float scale) {
     if (scale > 0.0f) {
       this->m_scale_.Sz = scale;
     }
+    ++m_revision_;
   }
 
   void SetScaleTotal(const float scale) {
     if (scale > 0.0f) {
       this->m_scale_.STotal = scale;
     }
+    ++m_revision_;
   }
 };
 
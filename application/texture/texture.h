@@ -0,0 +1,48 @@
+#ifndef TEXTURE_H_
+#define TEXTURE_H_
+
+#include <QImage>
+#include <QOpenGLTexture>
+#include <QString>
+#include <QVector>
+
+namespace s21 {
+
+struct TextureSampler {
+  QOpenGLTexture::WrapMode wrap = QOpenGLTexture::MirroredRepeat;
+  QOpenGLTexture::Filter min_filter = QOpenGLTexture::LinearMipMapNearest;
+  QOpenGLTexture::Filter mag_filter = QOpenGLTexture::Nearest;
+  bool mirrored = false;
+};
+
+struct Texture {
+  QOpenGLTexture texture;
+  QString path;
+  qint64 bytes = 0;
+
+  explicit Texture(const TextureSampler &sampler = TextureSampler())
+      : texture(QOpenGLTexture::Target2D) {
+    texture.create();
+    texture.setWrapMode(QOpenGLTexture::DirectionS, sampler.wrap);
+    texture.setWrapMode(QOpenGLTexture::DirectionT, sampler.wrap);
+    texture.setMinMagFilters(sampler.min_filter, sampler.mag_filter);
+  }
+
+  // Uploads a prepared RGBA8888 mip chain, level 0 first.
+  void SetData(const QVector<QImage> &levels) {
+    texture.setFormat(QOpenGLTexture::RGBA8_UNorm);
+    texture.setSize(levels[0].width(), levels[0].height());
+    texture.setMipLevels(levels.size());
+    texture.allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+    bytes = 0;
+    for (int i = 0; i < levels.size(); ++i) {
+      texture.setData(i, QOpenGLTexture::RGBA, QOpenGLTexture::UInt8,
+                      levels[i].constBits());
+      bytes += levels[i].sizeInBytes();
+    }
+  }
+};
+
+}  // namespace s21
+
+#endif  // TEXTURE_H_
@@ -0,0 +1,89 @@
+#include "texture_cache.h"
+
+#include <QFileInfo>
+
+#include "texture_loader.h"
+
+namespace s21 {
+
+QSharedPointer<Texture> TextureCache::Find(const QString &path,
+                                           const TextureSampler &sampler) {
+  return GetEntries().value(GetKey(path, sampler)).toStrongRef();
+}
+
+QSharedPointer<Texture> TextureCache::Insert(const QString &path,
+                                             const TextureSampler &sampler,
+                                             const QVector<QImage> &levels) {
+  QSharedPointer<Texture> texture = Find(path, sampler);
+  if (texture || levels.isEmpty()) {
+    return texture;
+  }
+
+  texture = QSharedPointer<Texture>::create(sampler);
+  texture->SetData(levels);
+  texture->path = QFileInfo(path).absoluteFilePath();
+  GetEntries().insert(GetKey(path, sampler), texture);
+  return texture;
+}
+
+QSharedPointer<Texture> TextureCache::Load(const QString &path,
+                                           const TextureSampler &sampler) {
+  QSharedPointer<Texture> texture = Find(path, sampler);
+  if (!texture) {
+    texture =
+        Insert(path, sampler, TextureLoader::Decode(path, sampler.mirrored));
+  }
+  return texture;
+}
+
+QSharedPointer<Texture> TextureCache::GetDefault(Qt::GlobalColor color) {
+  const QString key = "#default" + QString::number(color);
+  QSharedPointer<Texture> texture = GetEntries().value(key).toStrongRef();
+  if (!texture) {
+    QImage data(1, 1, QImage::Format_RGBA8888);
+    data.fill(color);
+    texture = QSharedPointer<Texture>::create();
+    texture->SetData({data});
+    GetEntries().insert(key, texture);
+  }
+  return texture;
+}
+
+int TextureCache::GetCount() {
+  auto &entries = GetEntries();
+  for (auto it = entries.begin(); it != entries.end();) {
+    if (it.value().isNull()) {
+      it = entries.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return entries.size();
+}
+
+qint64 TextureCache::GetBytes() {
+  qint64 bytes = 0;
+  for (auto &it : GetEntries()) {
+    const QSharedPointer<Texture> texture = it.toStrongRef();
+    if (texture) {
+      bytes += texture->bytes;
+    }
+  }
+  return bytes;
+}
+
+QString TextureCache::GetKey(const QString &path,
+                             const TextureSampler &sampler) {
+  return QFileInfo(path).absoluteFilePath() + "|" +
+         QString::number(sampler.wrap) + "|" +
+         QString::number(sampler.min_filter) + "|" +
+         QString::number(sampler.mag_filter) + "|" +
+         QString::number(sampler.mirrored);
+}
+
+QHash<QString, QWeakPointer<Texture>> &TextureCache::GetEntries() {
+  static QHash<QString, QWeakPointer<Texture>> entries;
+  return entries;
+}
+
+}  // namespace s21
@@ -0,0 +1,39 @@
+#ifndef TEXTURE_CACHE_H_
+#define TEXTURE_CACHE_H_
+
+#include <QHash>
+#include <QImage>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include <QWeakPointer>
+
+#include "texture.h"
+
+namespace s21 {
+
+// Process-wide cache of GPU textures. Entries are keyed by absolute path
+// and sampler state and live as long as some mesh holds a reference.
+// Must be used from the GL thread with a current context.
+class TextureCache {
+ public:
+  static QSharedPointer<Texture> Find(const QString &path,
+                                      const TextureSampler &sampler);
+  static QSharedPointer<Texture> Insert(const QString &path,
+                                        const TextureSampler &sampler,
+                                        const QVector<QImage> &levels);
+  static QSharedPointer<Texture> Load(const QString &path,
+                                      const TextureSampler &sampler);
+  static QSharedPointer<Texture> GetDefault(Qt::GlobalColor color);
+
+  static int GetCount();
+  static qint64 GetBytes();
+
+ private:
+  static QString GetKey(const QString &path, const TextureSampler &sampler);
+  static QHash<QString, QWeakPointer<Texture>> &GetEntries();
+};
+
+}  // namespace s21
+
+#endif  // TEXTURE_CACHE_H_
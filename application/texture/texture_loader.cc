@@ -0,0 +1,88 @@
+#include "texture_loader.h"
+
+#include <QMutexLocker>
+
+#include "parallel.h"
+
+namespace s21 {
+
+TextureLoader::TextureLoader() { m_pool_.setMaxThreadCount(WorkerCount()); }
+
+TextureLoader::~TextureLoader() {
+  m_pool_.clear();
+  m_pool_.waitForDone();
+}
+
+void TextureLoader::Prefetch(const QString &path) {
+  {
+    QMutexLocker locker(&m_mutex_);
+    if (path.isEmpty() || m_images_.contains(path)) {
+      return;
+    }
+    m_images_.insert(path, QVector<QImage>());
+  }
+  m_pool_.start([this, path]() {
+    QVector<QImage> levels = Decode(path);
+    QMutexLocker locker(&m_mutex_);
+    m_images_[path] = std::move(levels);
+  });
+}
+
+bool TextureLoader::Wait(const ImportProgress &progress) {
+  while (!m_pool_.waitForDone(50)) {
+    if (progress.IsCancelled()) {
+      m_pool_.clear();
+    }
+  }
+  return !progress.IsCancelled();
+}
+
+QVector<QImage> TextureLoader::Take(const QString &path) {
+  QMutexLocker locker(&m_mutex_);
+  return m_images_.take(path);
+}
+
+QStringList TextureLoader::GetFailed() const {
+  QMutexLocker locker(&m_mutex_);
+  QStringList paths;
+  for (auto it = m_images_.begin(); it != m_images_.end(); ++it) {
+    if (it.value().isEmpty()) {
+      paths << it.key();
+    }
+  }
+  return paths;
+}
+
+void TextureLoader::Clear() {
+  m_pool_.clear();
+  m_pool_.waitForDone();
+  QMutexLocker locker(&m_mutex_);
+  m_images_.clear();
+}
+
+QVector<QImage> TextureLoader::Decode(const QString &path, bool mirrored) {
+  QImage image(path);
+  if (image.isNull()) {
+    return {};
+  }
+  return BuildMipChain(mirrored ? image.mirrored() : image);
+}
+
+QVector<QImage> TextureLoader::BuildMipChain(QImage image) {
+  QVector<QImage> levels;
+  if (image.isNull()) {
+    return levels;
+  }
+  levels.push_back(image.convertToFormat(QImage::Format_RGBA8888));
+  while (levels.back().width() > 1 || levels.back().height() > 1) {
+    const QImage &last = levels.back();
+    const QImage level =
+        last.scaled(std::max(1, last.width() / 2),
+                    std::max(1, last.height() / 2), Qt::IgnoreAspectRatio,
+                    Qt::SmoothTransformation);
+    levels.push_back(level.convertToFormat(QImage::Format_RGBA8888));
+  }
+  return levels;
+}
+
+}  // namespace s21
@@ -0,0 +1,40 @@
+#ifndef TEXTURE_LOADER_H_
+#define TEXTURE_LOADER_H_
+
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+
+#include "import_progress.h"
+
+namespace s21 {
+
+// Decodes images and builds their mip chains on a private thread pool, so
+// that only the upload is left for the GL thread.
+class TextureLoader {
+ public:
+  TextureLoader();
+  ~TextureLoader();
+
+  void Prefetch(const QString &path);
+  bool Wait(const ImportProgress &progress);
+  QVector<QImage> Take(const QString &path);
+  QStringList GetFailed() const;
+  void Clear();
+
+  static QVector<QImage> Decode(const QString &path, bool mirrored = false);
+  static QVector<QImage> BuildMipChain(QImage image);
+
+ private:
+  QThreadPool m_pool_;
+  mutable QMutex m_mutex_;
+  QHash<QString, QVector<QImage>> m_images_;
+};
+
+}  // namespace s21
+
+#endif  // TEXTURE_LOADER_H_
@@ -4,17 +4,7 @@
 
 out vec4 FragColor;
 
-struct Material {
-    vec3 Ka;
-    vec3 Kd;
-    vec3 Ks;
-    float Ns;
-    float d;
-    float roughness;
-    float refraction;
-    float reflection;
-};
-
+// Laid out for std140: every scalar fills the padding after a vec3.
 struct DirLight {
     vec3 direction;
 
@@ -25,42 +15,72 @@ struct DirLight {
 
 struct PointLight {
     vec3 position;
-
     float constant;
-    float linear;
-    float quadratic;
 
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
 };
 
 struct SpotLight {
     vec3 position;
-    vec3 direction;
-    float cutOff;
-    float outerCutOff;
-
     float constant;
+    vec3 direction;
     float linear;
-    float quadratic;
 
     vec3 ambient;
+    float quadratic;
     vec3 diffuse;
+    float cutOff;
     vec3 specular;
+    float outerCutOff;
 };
 
 in vec3 FragPos;
 in vec3 Normal;
+flat in vec4 InstanceColor;
 
 uniform vec3 viewPos;
-uniform DirLight dirLight[20];
-uniform PointLight pointLight[20];
-uniform SpotLight spotLight[20];
-uniform Material material;
-uniform int CountdirLight;
-uniform int CountpointLight;
-uniform int CountspotLight;
+layout(std140) uniform DirLightBlock {
+    int CountdirLight;
+    DirLight dirLight[MAX_DIR_LIGHTS];
+};
+layout(std140) uniform PointLightBlock {
+    int CountpointLight;
+    PointLight pointLight[MAX_POINT_LIGHTS];
+};
+layout(std140) uniform SpotLightBlock {
+    int CountspotLight;
+    SpotLight spotLight[MAX_SPOT_LIGHTS];
+};
+struct Material {
+    vec3 Ka;
+    float Ns;
+    vec3 Kd;
+    float Ni;
+    vec3 Ks;
+    float d;
+    vec3 Ke;
+    float roughness;
+    float reflection;
+    float refraction;
+};
+#ifdef MULTI_DRAW
+layout(std430, binding = 1) readonly buffer MaterialBuffer {
+    Material materials[];
+};
+flat in uint MaterialIndex;
+#else
+// See MaterialBlock.
+layout(std140) uniform MaterialBlock {
+    Material value;
+} materialBlock;
+#endif
+// Material of the part being drawn, read at the start of main and tinted
+// by the color of the instance.
+Material material;
 uniform samplerCube skybox;
 
 uniform float eta = 0.66;
@@ -72,6 +92,15 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 float DistributionGGX(vec3 N, vec3 H, float a);
 
 void main() {
+#ifdef MULTI_DRAW
+    material = materials[MaterialIndex];
+#else
+    material = materialBlock.value;
+#endif
+    if (InstanceColor.a > 0.0) {
+        material.Ka = InstanceColor.rgb;
+        material.Kd = InstanceColor.rgb;
+    }
 //    // properties
     vec3 norm = normalize(Normal);
     vec3 viewDir = normalize(viewPos - FragPos);
@@ -6,14 +6,51 @@ layout (location = 4) in vec3 aBitangent;
 
 out vec3 FragPos;
 out vec3 Normal;
+flat out vec4 InstanceColor;
 
 uniform mat4 projection;
 uniform mat4 view;
+#ifdef MULTI_DRAW
+// Index of the DrawData of the command, repeated for every instance of its
+// model.
+layout (location = 5) in uint aDraw;
+
+struct Draw {
+  mat4 model;
+  vec3 positionOffset;
+  uint material;
+  vec3 positionScale;
+  int instanceBase;
+};
+layout(std430, binding = 0) readonly buffer DrawBuffer {
+  Draw draws[];
+};
+flat out uint MaterialIndex;
+#else
 uniform mat4 model;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+uniform int instanceBase;
+#endif
+// Placements of the models, five texels per instance, see InstanceData.
+uniform samplerBuffer instances;
 
 void main() {
-  FragPos = vec3(model * vec4(aPos, 1.0));
-  Normal = mat3(transpose(inverse(model))) * aNormal;
+#ifdef MULTI_DRAW
+  mat4 model = draws[aDraw].model;
+  vec3 positionOffset = draws[aDraw].positionOffset;
+  vec3 positionScale = draws[aDraw].positionScale;
+  MaterialIndex = draws[aDraw].material;
+  int instanceBase = draws[aDraw].instanceBase;
+#endif
+  int texel = 5 * (instanceBase + gl_InstanceID);
+  mat4 world = model * mat4(texelFetch(instances, texel),
+                            texelFetch(instances, texel + 1),
+                            texelFetch(instances, texel + 2),
+                            texelFetch(instances, texel + 3));
+  InstanceColor = texelFetch(instances, texel + 4);
+  FragPos = vec3(world * vec4(positionOffset + aPos * positionScale, 1.0));
+  Normal = mat3(transpose(inverse(world))) * aNormal;
 
   gl_Position = projection * view * vec4(FragPos, 1.0);
 }
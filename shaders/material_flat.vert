@@ -6,17 +6,7 @@ layout (location = 1) in vec3 aNormal;
 
 out vec4 FragColor;
 
-struct Material {
-    vec3 Ka;
-    vec3 Kd;
-    vec3 Ks;
-    float Ns;
-    float d;
-    float roughness;
-    float refraction;
-    float reflection;
-};
-
+// Laid out for std140: every scalar fills the padding after a vec3.
 struct DirLight {
     vec3 direction;
 
@@ -27,39 +17,67 @@ struct DirLight {
 
 struct PointLight {
     vec3 position;
-
     float constant;
-    float linear;
-    float quadratic;
 
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
 };
 
 struct SpotLight {
     vec3 position;
-    vec3 direction;
-    float cutOff;
-    float outerCutOff;
-
     float constant;
+    vec3 direction;
     float linear;
-    float quadratic;
 
     vec3 ambient;
+    float quadratic;
     vec3 diffuse;
+    float cutOff;
     vec3 specular;
+    float outerCutOff;
 };
 
 uniform vec3 viewPos;
-uniform DirLight dirLight[20];
-uniform PointLight pointLight[20];
-uniform SpotLight spotLight[20];
-uniform Material material;
-uniform int CountdirLight;
-uniform int CountpointLight;
-uniform int CountspotLight;
+layout(std140) uniform DirLightBlock {
+    int CountdirLight;
+    DirLight dirLight[MAX_DIR_LIGHTS];
+};
+layout(std140) uniform PointLightBlock {
+    int CountpointLight;
+    PointLight pointLight[MAX_POINT_LIGHTS];
+};
+layout(std140) uniform SpotLightBlock {
+    int CountspotLight;
+    SpotLight spotLight[MAX_SPOT_LIGHTS];
+};
+struct Material {
+    vec3 Ka;
+    float Ns;
+    vec3 Kd;
+    float Ni;
+    vec3 Ks;
+    float d;
+    vec3 Ke;
+    float roughness;
+    float reflection;
+    float refraction;
+};
+#ifdef MULTI_DRAW
+layout(std430, binding = 1) readonly buffer MaterialBuffer {
+    Material materials[];
+};
+#else
+// See MaterialBlock.
+layout(std140) uniform MaterialBlock {
+    Material value;
+} materialBlock;
+#endif
+// Material of the part being drawn, read at the start of main and tinted
+// by the color of the instance.
+Material material;
 
 // function prototypes
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
@@ -69,12 +87,53 @@ float DistributionGGX(vec3 N, vec3 H, float a);
 
 uniform mat4 projection;
 uniform mat4 view;
+#ifdef MULTI_DRAW
+// Index of the DrawData of the command, repeated for every instance of its
+// model.
+layout (location = 5) in uint aDraw;
+
+struct Draw {
+  mat4 model;
+  vec3 positionOffset;
+  uint material;
+  vec3 positionScale;
+  int instanceBase;
+};
+layout(std430, binding = 0) readonly buffer DrawBuffer {
+  Draw draws[];
+};
+#else
 uniform mat4 model;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+uniform int instanceBase;
+#endif
+// Placements of the models, five texels per instance, see InstanceData.
+uniform samplerBuffer instances;
 uniform samplerCube skybox;
 
 void main() {
-  vec3 FragPos = vec3(model * vec4(aPos, 1.0));
-  vec3 Normal = mat3(transpose(inverse(model))) * aNormal;
+#ifdef MULTI_DRAW
+  mat4 model = draws[aDraw].model;
+  vec3 positionOffset = draws[aDraw].positionOffset;
+  vec3 positionScale = draws[aDraw].positionScale;
+  material = materials[draws[aDraw].material];
+  int instanceBase = draws[aDraw].instanceBase;
+#else
+  material = materialBlock.value;
+#endif
+  int texel = 5 * (instanceBase + gl_InstanceID);
+  mat4 world = model * mat4(texelFetch(instances, texel),
+                            texelFetch(instances, texel + 1),
+                            texelFetch(instances, texel + 2),
+                            texelFetch(instances, texel + 3));
+  vec4 instanceColor = texelFetch(instances, texel + 4);
+  if (instanceColor.a > 0.0) {
+    material.Ka = instanceColor.rgb;
+    material.Kd = instanceColor.rgb;
+  }
+  vec3 FragPos = vec3(world * vec4(positionOffset + aPos * positionScale, 1.0));
+  vec3 Normal = mat3(transpose(inverse(world))) * aNormal;
 
       // properties
       vec3 norm = normalize(Normal);
@@ -4,19 +4,14 @@
 
 out vec4 FragColor;
 
-struct Material {
+struct Maps {
     sampler2D ambient;
     sampler2D diffuse;
     sampler2D specular;
     sampler2D normal;
-
-    float Ns;
-    float d;
-    float roughness;
-    float refraction;
-    float reflection;
 };
 
+// Laid out for std140: every scalar fills the padding after a vec3.
 struct DirLight {
     vec3 direction;
 
@@ -27,29 +22,27 @@ struct DirLight {
 
 struct PointLight {
     vec3 position;
-
     float constant;
-    float linear;
-    float quadratic;
 
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
 };
 
 struct SpotLight {
     vec3 position;
-    vec3 direction;
-    float cutOff;
-    float outerCutOff;
-
     float constant;
+    vec3 direction;
     float linear;
-    float quadratic;
 
     vec3 ambient;
+    float quadratic;
     vec3 diffuse;
+    float cutOff;
     vec3 specular;
+    float outerCutOff;
 };
 
 in vec3 FragPos;
@@ -57,13 +50,32 @@ in vec2 TexCoords;
 in mat3 TBN;
 
 uniform vec3 viewPos;
-uniform DirLight dirLight[20];
-uniform PointLight pointLight[20];
-uniform SpotLight spotLight[20];
-uniform Material material;
-uniform int CountdirLight;
-uniform int CountpointLight;
-uniform int CountspotLight;
+layout(std140) uniform DirLightBlock {
+    int CountdirLight;
+    DirLight dirLight[MAX_DIR_LIGHTS];
+};
+layout(std140) uniform PointLightBlock {
+    int CountpointLight;
+    PointLight pointLight[MAX_POINT_LIGHTS];
+};
+layout(std140) uniform SpotLightBlock {
+    int CountspotLight;
+    SpotLight spotLight[MAX_SPOT_LIGHTS];
+};
+uniform Maps maps;
+// Material of the part being drawn, see MaterialBlock.
+layout(std140) uniform MaterialBlock {
+    vec3 Ka;
+    float Ns;
+    vec3 Kd;
+    float Ni;
+    vec3 Ks;
+    float d;
+    vec3 Ke;
+    float roughness;
+    float reflection;
+    float refraction;
+} material;
 uniform samplerCube skybox;
 
 uniform float eta = 0.66;
@@ -76,7 +88,7 @@ float DistributionGGX(vec3 N, vec3 H, float a);
 
 void main() {
 //    // properties
-    vec3 norm = texture(material.normal, TexCoords).rgb;
+    vec3 norm = texture(maps.normal, TexCoords).rgb;
     norm = normalize(norm * 2.0 - 1.0);
 
     vec3 viewDir = TBN * normalize(viewPos - FragPos);
@@ -122,9 +134,9 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir) {
     vec3 reflectDir = reflect(-lightDir, normal);
     float spec = pow(max(dot(normal, halfwayDir), 0.0), material.Ns);
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.ambient, TexCoords));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-    vec3 specular = DistributionGGX(normal, halfwayDir, material.roughness) * light.specular * spec * vec3(texture(material.specular, TexCoords));
+    vec3 ambient = light.ambient * vec3(texture(maps.ambient, TexCoords));
+    vec3 diffuse = light.diffuse * diff * vec3(texture(maps.diffuse, TexCoords));
+    vec3 specular = DistributionGGX(normal, halfwayDir, material.roughness) * light.specular * spec * vec3(texture(maps.specular, TexCoords));
     return (ambient + diffuse + specular);
 }
 
@@ -141,9 +153,9 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
     float distance = length(light.position - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.ambient, TexCoords));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-    vec3 specular = DistributionGGX(normal, halfwayDir, material.roughness) * light.specular * spec * vec3(texture(material.specular, TexCoords));
+    vec3 ambient = light.ambient * vec3(texture(maps.ambient, TexCoords));
+    vec3 diffuse = light.diffuse * diff * vec3(texture(maps.diffuse, TexCoords));
+    vec3 specular = DistributionGGX(normal, halfwayDir, material.roughness) * light.specular * spec * vec3(texture(maps.specular, TexCoords));
     ambient *= attenuation;
     diffuse *= attenuation;
     specular *= attenuation;
@@ -167,9 +179,9 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
     float epsilon = light.cutOff - light.outerCutOff;
     float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.ambient, TexCoords));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-    vec3 specular = DistributionGGX(normal, halfwayDir, material.roughness) * light.specular * spec * vec3(texture(material.specular, TexCoords));
+    vec3 ambient = light.ambient * vec3(texture(maps.ambient, TexCoords));
+    vec3 diffuse = light.diffuse * diff * vec3(texture(maps.diffuse, TexCoords));
+    vec3 specular = DistributionGGX(normal, halfwayDir, material.roughness) * light.specular * spec * vec3(texture(maps.specular, TexCoords));
     ambient *= attenuation * intensity;
     diffuse *= attenuation * intensity;
     specular *= attenuation * intensity;
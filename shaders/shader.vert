@@ -2,7 +2,7 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
-layout (location = 3) in vec3 aTangent;
+layout (location = 3) in vec4 aTangent;
 layout (location = 4) in vec3 aBitangent;
 
 out vec3 FragPos;
@@ -12,14 +12,28 @@ out mat3 TBN;
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 model;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+uniform int instanceBase;
+// Placements of the models, five texels per instance, see InstanceData.
+uniform samplerBuffer instances;
+uniform bool packedTangents;
 
 void main() {
-  FragPos = vec3(model * vec4(aPos, 1.0));
+  int texel = 5 * (instanceBase + gl_InstanceID);
+  mat4 world = model * mat4(texelFetch(instances, texel),
+                            texelFetch(instances, texel + 1),
+                            texelFetch(instances, texel + 2),
+                            texelFetch(instances, texel + 3));
+  FragPos = vec3(world * vec4(positionOffset + aPos * positionScale, 1.0));
   TexCoords = aTexCoords;
 
-  vec3 T = normalize(vec3(model * vec4(aTangent,   0.0)));
-  vec3 B = normalize(vec3(model * vec4(aBitangent, 0.0)));
-  vec3 N = normalize(vec3(model * vec4(normalize(aNormal), 0.0)));
+  vec3 bitangent = packedTangents
+      ? aTangent.w * cross(normalize(aNormal), aTangent.xyz)
+      : aBitangent;
+  vec3 T = normalize(vec3(world * vec4(aTangent.xyz, 0.0)));
+  vec3 B = normalize(vec3(world * vec4(bitangent, 0.0)));
+  vec3 N = normalize(vec3(world * vec4(normalize(aNormal), 0.0)));
 
   T = normalize(T - dot(T, N) * N);
   TBN = transpose(mat3(T, B, N));
@@ -2,7 +2,7 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
-layout (location = 3) in vec3 aTangent;
+layout (location = 3) in vec4 aTangent;
 layout (location = 4) in vec3 aBitangent;
 
 #define PI 3.1415926538
@@ -10,22 +10,23 @@ layout (location = 4) in vec3 aBitangent;
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 model;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+uniform int instanceBase;
+// Placements of the models, five texels per instance, see InstanceData.
+uniform samplerBuffer instances;
+uniform bool packedTangents;
 
 out vec4 FragColor;
 
-struct Material {
+struct Maps {
     sampler2D ambient;
     sampler2D diffuse;
     sampler2D specular;
     sampler2D normal;
-
-    float Ns;
-    float d;
-    float roughness;
-    float refraction;
-    float reflection;
 };
 
+// Laid out for std140: every scalar fills the padding after a vec3.
 struct DirLight {
     vec3 direction;
 
@@ -36,41 +37,58 @@ struct DirLight {
 
 struct PointLight {
     vec3 position;
-
     float constant;
-    float linear;
-    float quadratic;
 
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
 };
 
 struct SpotLight {
     vec3 position;
-    vec3 direction;
-    float cutOff;
-    float outerCutOff;
-
     float constant;
+    vec3 direction;
     float linear;
-    float quadratic;
 
     vec3 ambient;
+    float quadratic;
     vec3 diffuse;
+    float cutOff;
     vec3 specular;
+    float outerCutOff;
 };
 
 mat3 TBN;
 
 uniform vec3 viewPos;
-uniform DirLight dirLight[20];
-uniform PointLight pointLight[20];
-uniform SpotLight spotLight[20];
-uniform Material material;
-uniform int CountdirLight;
-uniform int CountpointLight;
-uniform int CountspotLight;
+layout(std140) uniform DirLightBlock {
+    int CountdirLight;
+    DirLight dirLight[MAX_DIR_LIGHTS];
+};
+layout(std140) uniform PointLightBlock {
+    int CountpointLight;
+    PointLight pointLight[MAX_POINT_LIGHTS];
+};
+layout(std140) uniform SpotLightBlock {
+    int CountspotLight;
+    SpotLight spotLight[MAX_SPOT_LIGHTS];
+};
+uniform Maps maps;
+// Material of the part being drawn, see MaterialBlock.
+layout(std140) uniform MaterialBlock {
+    vec3 Ka;
+    float Ns;
+    vec3 Kd;
+    float Ni;
+    vec3 Ks;
+    float d;
+    vec3 Ke;
+    float roughness;
+    float reflection;
+    float refraction;
+} material;
 uniform samplerCube skybox;
 
 // function prototypes
@@ -80,14 +98,22 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 float DistributionGGX(vec3 N, vec3 H, float a);
 
 void main() {
-  vec3 FragPos = vec3(model * vec4(aPos, 1.0));
-
-  vec3 T = normalize(vec3(model * vec4(aTangent,   0.0)));
-  vec3 B = normalize(vec3(model * vec4(aBitangent, 0.0)));
-  vec3 N = normalize(vec3(model * vec4(normalize(aNormal), 0.0)));
+  int texel = 5 * (instanceBase + gl_InstanceID);
+  mat4 world = model * mat4(texelFetch(instances, texel),
+                            texelFetch(instances, texel + 1),
+                            texelFetch(instances, texel + 2),
+                            texelFetch(instances, texel + 3));
+  vec3 FragPos = vec3(world * vec4(positionOffset + aPos * positionScale, 1.0));
+
+  vec3 bitangent = packedTangents
+      ? aTangent.w * cross(normalize(aNormal), aTangent.xyz)
+      : aBitangent;
+  vec3 T = normalize(vec3(world * vec4(aTangent.xyz, 0.0)));
+  vec3 B = normalize(vec3(world * vec4(bitangent, 0.0)));
+  vec3 N = normalize(vec3(world * vec4(normalize(aNormal), 0.0)));
 
   // properties
-  vec3 norm = texture(material.normal, aTexCoords).rgb;
+  vec3 norm = texture(maps.normal, aTexCoords).rgb;
   norm = normalize(norm * 2.0 - 1.0);
 
   T = normalize(T - dot(T, N) * N);
@@ -138,9 +164,9 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir) {
     vec3 reflectDir = reflect(-lightDir, normal);
     float spec = pow(max(dot(normal, halfwayDir), 0.0), material.Ns);
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.ambient, aTexCoords));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, aTexCoords));
-    vec3 specular = DistributionGGX(normal, halfwayDir, material.roughness) * light.specular * spec * vec3(texture(material.specular, aTexCoords));
+    vec3 ambient = light.ambient * vec3(texture(maps.ambient, aTexCoords));
+    vec3 diffuse = light.diffuse * diff * vec3(texture(maps.diffuse, aTexCoords));
+    vec3 specular = DistributionGGX(normal, halfwayDir, material.roughness) * light.specular * spec * vec3(texture(maps.specular, aTexCoords));
     return (ambient + diffuse + specular);
 }
 
@@ -157,9 +183,9 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
     float distance = length(light.position - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.ambient, aTexCoords));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, aTexCoords));
-    vec3 specular = DistributionGGX(normal, halfwayDir, material.roughness) * light.specular * spec * vec3(texture(material.specular, aTexCoords));
+    vec3 ambient = light.ambient * vec3(texture(maps.ambient, aTexCoords));
+    vec3 diffuse = light.diffuse * diff * vec3(texture(maps.diffuse, aTexCoords));
+    vec3 specular = DistributionGGX(normal, halfwayDir, material.roughness) * light.specular * spec * vec3(texture(maps.specular, aTexCoords));
     ambient *= attenuation;
     diffuse *= attenuation;
     specular *= attenuation;
@@ -183,9 +209,9 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
     float epsilon = light.cutOff - light.outerCutOff;
     float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.ambient, aTexCoords));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, aTexCoords));
-    vec3 specular = DistributionGGX(normal, halfwayDir, material.roughness) * light.specular * spec * vec3(texture(material.specular, aTexCoords));
+    vec3 ambient = light.ambient * vec3(texture(maps.ambient, aTexCoords));
+    vec3 diffuse = light.diffuse * diff * vec3(texture(maps.diffuse, aTexCoords));
+    vec3 specular = DistributionGGX(normal, halfwayDir, material.roughness) * light.specular * spec * vec3(texture(maps.specular, aTexCoords));
     ambient *= attenuation * intensity;
     diffuse *= attenuation * intensity;
     specular *= attenuation * intensity;
@@ -4,10 +4,20 @@ layout (location = 0) in vec3 aPos;
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 model;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+uniform int instanceBase;
+// Placements of the models, five texels per instance, see InstanceData.
+uniform samplerBuffer instances;
 
 uniform float PointSize;
 
 void main() {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    int texel = 5 * (instanceBase + gl_InstanceID);
+    mat4 world = model * mat4(texelFetch(instances, texel),
+                              texelFetch(instances, texel + 1),
+                              texelFetch(instances, texel + 2),
+                              texelFetch(instances, texel + 3));
+    gl_Position = projection * view * world * vec4(positionOffset + aPos * positionScale, 1.0);
     gl_PointSize = PointSize;
 }